@@ -0,0 +1,208 @@
+#include "calculator.h"
+#include "lexer.h"
+#include "parser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+    Замер отдельных этапов на постоянном наборе выражений: скорость
+    лексера (МБ/с), парсера (узлов/с), обхода дерева ASTNode::Evaluate
+    (нс на вычисление) и полного Calculator::Calculate (нс на вызов).
+    Каждый этап измеряется kSamples раз; по выборке выводятся медиана и
+    99-й перцентиль (для скоростей - значение, медленнее которого 1%
+    замеров). С флагом --json отчёт выводится в формате JSON для
+    сравнения между версиями.
+*/
+
+namespace {
+
+    constexpr int kSamples = 1000;
+    // Замер короче разрешения таймера повторяется несколько раз подряд
+    constexpr double kSampleNanoseconds = 20000.0;
+
+    struct Summary {
+        double median = 0.0;
+        double p99 = 0.0;
+    };
+
+    struct Result {
+        std::string expression;
+        size_t bytes = 0;
+        size_t nodes = 0;
+        Summary lexer_mb_per_second;
+        Summary parser_nodes_per_second;
+        Summary evaluate_ns;
+        Summary calculate_ns;
+    };
+
+    class NodeCounter : public ASTVisitor {
+    public:
+        void Visit(const NumberNode&) override { ++count; }
+        void Visit(const VariableNode&) override { ++count; }
+        void Visit(const BinaryOpNode& node) override {
+            ++count;
+            node.GetLeft().Accept(*this);
+            node.GetRight().Accept(*this);
+        }
+        void Visit(const UnaryOpNode& node) override {
+            ++count;
+            node.GetOperand().Accept(*this);
+        }
+        void Visit(const FunctionNode& node) override {
+            ++count;
+            node.GetArgument()->Accept(*this);
+        }
+        size_t count = 0;
+    };
+
+    // Выборка времени одной операции в наносекундах, по возрастанию
+    template <typename Func>
+    std::vector<double> SampleNanoseconds(Func func) {
+        using Clock = std::chrono::steady_clock;
+        auto start = Clock::now();
+        func();
+        const double estimate = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        const size_t repeats = std::max<size_t>(1, static_cast<size_t>(kSampleNanoseconds / std::max(estimate, 1.0)));
+
+        std::vector<double> samples(kSamples);
+        for (double& sample : samples) {
+            start = Clock::now();
+            for (size_t repeat = 0; repeat < repeats; ++repeat) func();
+            sample = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / repeats;
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples;
+    }
+
+    double Percentile(const std::vector<double>& sorted, double fraction) {
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+    }
+
+    Summary Latency(const std::vector<double>& sorted) {
+        return {Percentile(sorted, 0.5), Percentile(sorted, 0.99)};
+    }
+
+    // Скорость при заданном объёме работы: p99 соответствует медленным замерам
+    Summary Throughput(const std::vector<double>& sorted, double work) {
+        return {work * 1e9 / Percentile(sorted, 0.5), work * 1e9 / Percentile(sorted, 0.99)};
+    }
+
+    std::string LongExpression() {
+        std::string expression = "x";
+        for (int term = 1; term < 200; ++term) {
+            expression += term % 3 == 0 ? " - " : " + ";
+            expression += std::to_string(term) + " * " + (term % 2 == 0 ? "y" : "sin(z)");
+        }
+        return expression;
+    }
+
+    Result Measure(Calculator& calc, const std::string& expression, const Token::Variables& vars) {
+        Result result;
+        result.expression = expression;
+        result.bytes = expression.size();
+
+        volatile size_t token_sink = 0;
+        const auto lexing = SampleNanoseconds([&] {
+            Lexer lexer(expression);
+            token_sink = lexer.GetTokens().size();
+        });
+
+        Lexer tree_lexer(expression);
+        const Token::Tokens tokens = tree_lexer.GetTokens();
+        volatile const void* tree_sink = nullptr;
+        const auto parsing = SampleNanoseconds([&] {
+            Parser parser(tokens, expression);
+            tree_sink = parser.Parse().get();
+        });
+
+        Parser tree_parser(tokens, expression);
+        const std::shared_ptr<const ASTNode> tree = tree_parser.Parse();
+        NodeCounter counter;
+        tree->Accept(counter);
+        result.nodes = counter.count;
+
+        volatile double value_sink = 0.0;
+        const auto evaluate = SampleNanoseconds([&] { value_sink = tree->Evaluate(vars); });
+        const auto calculate = SampleNanoseconds([&] { value_sink = calc.Calculate(expression, vars); });
+
+        result.lexer_mb_per_second = Throughput(lexing, result.bytes / 1e6);
+        result.parser_nodes_per_second = Throughput(parsing, static_cast<double>(result.nodes));
+        result.evaluate_ns = Latency(evaluate);
+        result.calculate_ns = Latency(calculate);
+        return result;
+    }
+
+    std::string JsonString(const std::string& text) {
+        std::string out = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') out.push_back('\\');
+            out.push_back(c);
+        }
+        return out + "\"";
+    }
+
+    void PrintJson(const std::vector<Result>& results) {
+        std::printf("{\n  \"samples\": %d,\n  \"results\": [\n", kSamples);
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::printf("    {\"expression\": %s, \"bytes\": %zu, \"nodes\": %zu,\n", JsonString(r.expression).c_str(),
+                        r.bytes, r.nodes);
+            std::printf("     \"lexer_mb_per_s\": {\"median\": %.3f, \"p99\": %.3f},\n",
+                        r.lexer_mb_per_second.median, r.lexer_mb_per_second.p99);
+            std::printf("     \"parser_nodes_per_s\": {\"median\": %.0f, \"p99\": %.0f},\n",
+                        r.parser_nodes_per_second.median, r.parser_nodes_per_second.p99);
+            std::printf("     \"evaluate_ns\": {\"median\": %.2f, \"p99\": %.2f},\n",
+                        r.evaluate_ns.median, r.evaluate_ns.p99);
+            std::printf("     \"calculate_ns\": {\"median\": %.2f, \"p99\": %.2f}}%s\n",
+                        r.calculate_ns.median, r.calculate_ns.p99, i + 1 < results.size() ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+    }
+
+    void PrintTable(const std::vector<Result>& results) {
+        std::printf("%-40s %19s %21s %19s %21s\n", "expression", "lexer MB/s", "parser Mnodes/s",
+                    "evaluate ns", "calculate ns");
+        std::printf("%-40s %9s %9s %10s %10s %9s %9s %10s %10s\n", "", "median", "p99", "median", "p99",
+                    "median", "p99", "median", "p99");
+        for (const Result& r : results) {
+            std::string name = r.expression.size() > 40 ? r.expression.substr(0, 37) + "..." : r.expression;
+            std::printf("%-40s %9.1f %9.1f %10.2f %10.2f %9.1f %9.1f %10.1f %10.1f\n", name.c_str(),
+                        r.lexer_mb_per_second.median, r.lexer_mb_per_second.p99,
+                        r.parser_nodes_per_second.median / 1e6, r.parser_nodes_per_second.p99 / 1e6,
+                        r.evaluate_ns.median, r.evaluate_ns.p99, r.calculate_ns.median, r.calculate_ns.p99);
+        }
+    }
+
+} //End of anonymous namespace
+
+int main(int argc, char** argv) {
+    const bool json = argc > 1 && std::strcmp(argv[1], "--json") == 0;
+
+    const std::vector<std::string> expressions = {
+        "2 + 3 * 4",
+        "x * y + z",
+        "(x + y) * (x - y) / (z + 10)",
+        "x^2 + 3 * x * y - y / (z + 4) + 2 * PI * x",
+        "sin(x) * cos(y) + sin(cos(z)) - cos(x + 1)",
+        "-(x - -y) * -z + 5! / (1 + PI^z)",
+        "((((x + 1) * (y + 2)) / ((z + 3) - 0.5)) ^ 2)",
+        LongExpression(),
+    };
+    const Token::Variables vars{{"x", 1.5}, {"y", 2.5}, {"z", 0.75}};
+
+    Calculator calc;
+    std::vector<Result> results;
+    for (const std::string& expression : expressions) {
+        results.push_back(Measure(calc, expression, vars));
+    }
+    if (json) {
+        PrintJson(results);
+    } else {
+        PrintTable(results);
+    }
+    return 0;
+}
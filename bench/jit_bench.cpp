@@ -0,0 +1,89 @@
+#include "calculator.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/*
+    Сравнение способов вычисления: обход дерева, байт-код и машинный код.
+    Для каждого выражения измеряется время одного скалярного вычисления
+    и время на строку в пакетном режиме.
+*/
+
+namespace {
+
+    constexpr size_t kRows = 1 << 18;
+    constexpr int kRepeats = 5;
+
+    const char* EngineName(Engine engine) {
+        switch (engine) {
+            case Engine::TREE_WALKER: return "tree";
+            case Engine::BYTECODE: return "bytecode";
+            case Engine::JIT: return "jit";
+        }
+        return "?";
+    }
+
+    template <typename Func>
+    double BestNanoseconds(size_t operations, Func func) {
+        double best = 0.0;
+        for (int repeat = 0; repeat < kRepeats; ++repeat) {
+            auto start = std::chrono::steady_clock::now();
+            func();
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            double per_operation = elapsed.count() / operations;
+            if (repeat == 0 || per_operation < best) best = per_operation;
+        }
+        return best;
+    }
+
+} //End of anonymous namespace
+
+int main() {
+    const char* expressions[] = {
+        "x * y + z",
+        "(x + y) * (x - y) / (z + 10)",
+        "x^2 + 3 * x * y - y / (z + 4) + 2 * PI * x",
+        "sin(x) * cos(y) + sin(z)",
+    };
+
+    std::mt19937_64 generator(11);
+    std::uniform_real_distribution<double> distribution(0.5, 5.0);
+    std::vector<std::vector<double>> data(3, std::vector<double>(kRows));
+    for (auto& column : data) {
+        for (double& value : column) value = distribution(generator);
+    }
+
+    Calculator calc;
+    std::printf("%-45s %-9s %12s %12s\n", "expression", "engine", "ns/eval", "batch ns/row");
+    for (const char* expression : expressions) {
+        for (Engine engine : {Engine::TREE_WALKER, Engine::BYTECODE, Engine::JIT}) {
+            CompileOptions options;
+            options.engine = engine;
+            CompiledExpression compiled = calc.Compile(expression, options);
+
+            std::vector<const double*> columns;
+            for (const std::string& name : compiled.GetVariableNames()) {
+                columns.push_back(data[name[0] - 'x'].data());
+            }
+
+            volatile double sink = 0.0;
+            std::vector<double> slots(columns.size());
+            const double scalar = BestNanoseconds(kRows, [&] {
+                double sum = 0.0;
+                for (size_t row = 0; row < kRows; ++row) {
+                    for (size_t slot = 0; slot < columns.size(); ++slot) slots[slot] = columns[slot][row];
+                    sum += compiled.Evaluate(slots.data(), slots.size());
+                }
+                sink = sum;
+            });
+
+            std::vector<double> out(kRows);
+            const double batch = BestNanoseconds(kRows, [&] {
+                compiled.EvaluateBatch(columns, out.data(), kRows);
+            });
+            std::printf("%-45s %-9s %12.2f %12.2f\n", expression, EngineName(compiled.GetEngine()), scalar, batch);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "calculator.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+/*
+    Отчёт о масштабировании параллельного пакетного вычисления: время и
+    ускорение для числа потоков от 1 до N. Результат каждого прогона
+    сравнивается с последовательным вычислением.
+*/
+
+namespace {
+
+    constexpr size_t kRows = 8 * 1000 * 1000;
+    constexpr int kRepeats = 5;
+
+} //End of anonymous namespace
+
+int main(int argc, char** argv) {
+    size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    if (argc > 1) {
+        max_threads = std::max<size_t>(std::strtoul(argv[1], nullptr, 10), 1);
+    }
+
+    // Факториал и возведение в степень дают неравномерную стоимость строк
+    const std::string expression = "sin(x) * y^2.5 + n! / (1 + cos(y))";
+    std::mt19937_64 generator(7);
+    std::uniform_real_distribution<double> real(0.0, 10.0);
+    std::uniform_int_distribution<int> integer(0, 30);
+    std::vector<double> x(kRows), y(kRows), n(kRows);
+    for (size_t row = 0; row < kRows; ++row) {
+        x[row] = real(generator);
+        y[row] = real(generator);
+        n[row] = integer(generator);
+    }
+
+    Calculator calc;
+    CompiledExpression compiled = calc.Compile(expression);
+    std::vector<const double*> columns(compiled.GetVariableNames().size());
+    for (const auto& [name, column] : {std::pair{"x", &x}, std::pair{"y", &y}, std::pair{"n", &n}}) {
+        columns[compiled.GetVariableSlot(name)] = column->data();
+    }
+
+    std::vector<double> reference(kRows);
+    compiled.EvaluateBatch(columns, reference.data(), kRows);
+
+    std::printf("expression: %s, rows: %zu\n", expression.c_str(), kRows);
+    std::printf("%8s %12s %10s %10s\n", "threads", "ms", "speedup", "identical");
+    std::vector<size_t> thread_counts;
+    for (size_t threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    double single_thread_ms = 0.0;
+    for (size_t threads : thread_counts) {
+        ThreadPool pool(threads);
+        std::vector<double> out(kRows);
+        double best_ms = 0.0;
+        for (int repeat = 0; repeat < kRepeats; ++repeat) {
+            auto start = std::chrono::steady_clock::now();
+            compiled.EvaluateBatch(columns, out.data(), kRows, pool);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (repeat == 0 || elapsed.count() < best_ms) best_ms = elapsed.count();
+        }
+        if (threads == 1) single_thread_ms = best_ms;
+        const bool identical = std::memcmp(out.data(), reference.data(), kRows * sizeof(double)) == 0;
+        std::printf("%8zu %12.2f %10.2f %10s\n", threads, best_ms, single_thread_ms / best_ms,
+                    identical ? "yes" : "NO");
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "arrow_ipc.h"
+#include "compiled_expression.h"
+#include "token.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+    Вычисление одного выражения по пакетам записей файла Arrow IPC.
+    Столбцы с именами переменных выражения подставляются в них, а
+    переменные без столбца берутся из значений по умолчанию (--var).
+    Выражение вычисляется прямо над буферами отображённого файла, а
+    результат записывается новым столбцом float64 рядом с исходными.
+    Результат пропущен (null), если пропущено значение одной из переменных
+    или вычисление строки дало ошибку.
+*/
+class ArrowEvaluator {
+public:
+    explicit ArrowEvaluator(const CompiledExpression& compiled, Token::Variables defaults = {},
+                            std::string result_column = "result");
+
+    void Run(const Arrow::Reader& reader, int output_fd);
+private:
+    const CompiledExpression& compiled_;
+    Token::Variables defaults_;
+    std::string result_column_;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include "file_io.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+    Чтение и запись файлов Apache Arrow IPC (файловый формат, метаданные
+    версии V5) без внешних библиотек: метаданные FlatBuffers разбираются и
+    строятся вручную. Поддерживаются только столбцы float64 без сжатия и
+    словарей. Читатель отображает файл в память и отдаёт указатели прямо на
+    буферы столбцов, а писатель записывает переданные буферы без копирования.
+*/
+namespace Arrow {
+
+    // Положение пакета записей в файле (структура Block оглавления)
+    struct Block {
+        uint64_t offset = 0;
+        uint32_t metadata_length = 0;
+        uint64_t body_length = 0;
+    };
+
+    struct RecordBatch {
+        size_t row_count = 0;
+        // Значения столбцов в отображении файла
+        std::vector<const double*> columns;
+        // Маски допустимых строк (младший бит - первая строка) или nullptr без пропусков
+        std::vector<const uint8_t*> validity;
+    };
+
+    class Reader {
+    public:
+        explicit Reader(const std::string& path);
+
+        const std::vector<std::string>& GetColumnNames() const { return column_names_; }
+        size_t GetBatchCount() const { return batches_.size(); }
+        // Метаданные пакета проверяются при каждом обращении
+        RecordBatch GetBatch(size_t index) const;
+    private:
+        FileIo::MappedFile file_;
+        std::vector<std::string> column_names_;
+        std::vector<Block> batches_;
+    };
+
+    class Writer {
+    public:
+        Writer(int fd, std::vector<std::string> column_names);
+
+        // validity[i] - битовая маска допустимых строк столбца i (младший бит - первая
+        // строка) или nullptr, если пропусков нет
+        void WriteBatch(size_t row_count, const std::vector<const double*>& columns,
+                        const std::vector<const uint8_t*>& validity);
+        // Записывает оглавление; без него файл не читается
+        void Finish();
+    private:
+        void WriteMessage(const std::string& metadata, uint64_t body_length, Block* block);
+        void Write(const void* data, size_t size);
+        void WritePadding(size_t size);
+    private:
+        int fd_;
+        std::vector<std::string> column_names_;
+        std::vector<Block> batches_;
+        uint64_t position_ = 0;
+    };
+
+} //End of namespace Arrow
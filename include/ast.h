@@ -1,11 +1,32 @@
 #pragma once
 #include "token.h"
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+
+class NumberNode;
+class VariableNode;
+class BinaryOpNode;
+class UnaryOpNode;
+class FunctionNode;
+
+class ASTVisitor {
+public:
+    virtual ~ASTVisitor() = default;
+    virtual void Visit(const NumberNode& node) = 0;
+    virtual void Visit(const VariableNode& node) = 0;
+    virtual void Visit(const BinaryOpNode& node) = 0;
+    virtual void Visit(const UnaryOpNode& node) = 0;
+    virtual void Visit(const FunctionNode& node) = 0;
+};
 
 class ASTNode {
 public:
     virtual ~ASTNode() = default;
     virtual double Evaluate(const Token::Variables& vars) const = 0;
+    virtual void Accept(ASTVisitor& visitor) const = 0;
 };
 
 class NumberNode : public ASTNode {
@@ -13,38 +34,121 @@ class NumberNode : public ASTNode {
 public:
     NumberNode(double val) : value_(val) {}
     double Evaluate(const Token::Variables& vars) const override { return value_; }
+    void Accept(ASTVisitor& visitor) const override { visitor.Visit(*this); }
+    double GetValue() const { return value_; }
 };
 
 class VariableNode : public ASTNode {
-    std::string name_;
+    std::pmr::string name_;
 public:
-    VariableNode(const std::string& name) : name_(name) {}
+    VariableNode(std::string_view name, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : name_(name, resource) {}
     double Evaluate(const Token::Variables& vars) const override;
+    void Accept(ASTVisitor& visitor) const override { visitor.Visit(*this); }
+    std::string_view GetName() const { return name_; }
 };
 
+/*
+    Левоассоциативная цепочка a + b + c + ... разбирается в ((a + b) + c) + ...
+    и может быть сколь угодно длинной. Поэтому проходы по дереву, вычисление
+    и деструктор идут по левым бинарным операндам циклом (GetLeftBinary),
+    а рекурсия остаётся только для правых операндов, унарных операторов и
+    аргументов функций - их вложенность ограничивает Parser::kMaxDepth.
+*/
 class BinaryOpNode : public ASTNode {
     Token::TokenType operator_type_;
-    std::unique_ptr<ASTNode> left_node_, right_node_;
+    std::shared_ptr<const ASTNode> left_node_, right_node_;
+    const BinaryOpNode* left_binary_;
 public:
-    BinaryOpNode(Token::TokenType operator_type, std::unique_ptr<ASTNode> left_node, std::unique_ptr<ASTNode> right_node)
-        : operator_type_(operator_type), left_node_(std::move(left_node)), right_node_(std::move(right_node)) {}
+    BinaryOpNode(Token::TokenType operator_type, std::shared_ptr<const ASTNode> left_node, std::shared_ptr<const ASTNode> right_node)
+        : operator_type_(operator_type), left_node_(std::move(left_node)), right_node_(std::move(right_node)),
+          left_binary_(dynamic_cast<const BinaryOpNode*>(left_node_.get())) {}
+    ~BinaryOpNode() override;
     double Evaluate(const Token::Variables& vars) const override;
+    void Accept(ASTVisitor& visitor) const override { visitor.Visit(*this); }
+    Token::TokenType GetOperatorType() const { return operator_type_; }
+    const ASTNode& GetLeft() const { return *left_node_; }
+    const ASTNode& GetRight() const { return *right_node_; }
+    const std::shared_ptr<const ASTNode>& GetLeftPtr() const { return left_node_; }
+    const std::shared_ptr<const ASTNode>& GetRightPtr() const { return right_node_; }
+    // Левый операнд, если это тоже бинарный узел, иначе nullptr
+    const BinaryOpNode* GetLeftBinary() const { return left_binary_; }
 };
 
 class UnaryOpNode : public ASTNode {
     Token::TokenType un_operator_type_;
-    std::unique_ptr<ASTNode> operand_;
+    std::shared_ptr<const ASTNode> operand_;
 public:
-    UnaryOpNode(Token::TokenType un_operator_type, std::unique_ptr<ASTNode> opnd)
+    UnaryOpNode(Token::TokenType un_operator_type, std::shared_ptr<const ASTNode> opnd)
         : un_operator_type_(un_operator_type), operand_(std::move(opnd)) {}
     double Evaluate(const Token::Variables& vars) const override;
+    void Accept(ASTVisitor& visitor) const override { visitor.Visit(*this); }
+    Token::TokenType GetOperatorType() const { return un_operator_type_; }
+    const ASTNode& GetOperand() const { return *operand_; }
+    const std::shared_ptr<const ASTNode>& GetOperandPtr() const { return operand_; }
 };
 
 class FunctionNode : public ASTNode {
-    std::string name_;
-    std::unique_ptr<ASTNode> args_;
+    std::pmr::string name_;
+    // Реализации разрешаются при разборе, вычисление обходится без поиска по имени
+    double (*function_)(double);
+    void (*block_function_)(double*, size_t);
+    std::shared_ptr<const ASTNode> args_;
 public:
-    FunctionNode(const std::string& name, std::unique_ptr<ASTNode> arg_expr)
-        : name_(name), args_(std::move(arg_expr)) {}
+    FunctionNode(std::string_view name, const Token::FunctionEntry& function, std::shared_ptr<const ASTNode> arg_expr,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : name_(name, resource), function_(function.function), block_function_(function.block_function),
+          args_(std::move(arg_expr)) {}
     double Evaluate(const Token::Variables& vars) const override;
-};
\ No newline at end of file
+    void Accept(ASTVisitor& visitor) const override { visitor.Visit(*this); }
+    std::string_view GetName() const { return name_; }
+    Token::FunctionEntry GetFunction() const { return {name_, function_, block_function_}; }
+    const ASTNode* GetArgument() const { return args_.get(); }
+    const std::shared_ptr<const ASTNode>& GetArgumentPtr() const { return args_; }
+};
+
+/*
+    Создаёт узел в заданном ресурсе памяти: узел и блок управления shared_ptr
+    размещаются одним выделением. При компиляции ресурсом служит арена
+    выражения, поэтому ресурс должен пережить все ссылки на узлы.
+*/
+template <typename Node, typename... Args>
+std::shared_ptr<const ASTNode> MakeNode(std::pmr::memory_resource* resource, Args&&... args) {
+    return std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>(resource), std::forward<Args>(args)...);
+}
+
+namespace Operations {
+
+    /*
+        Ошибки вычисления на данных. Значения - отдельные биты, поэтому коды
+        нескольких строк можно объединять в общую маску. Вычисление без
+        исключений записывает код первой ошибки строки, а её результат
+        заменяет на NaN.
+    */
+    enum class EvalError : uint8_t {
+        NONE = 0,
+        NON_FINITE_RESULT = 1 << 0,
+        FACTORIAL_DOMAIN = 1 << 1,
+        FACTORIAL_OVERFLOW = 1 << 2
+    };
+
+    // Текст исключения, которое бросает вычисление с исключениями для этой ошибки
+    const char* GetErrorMessage(EvalError error);
+
+    double ResolveVariable(std::string_view name, const Token::Variables& vars);
+    double Binary(Token::TokenType operator_type, double left, double right);
+    double Unary(Token::TokenType operator_type, double value);
+    // Варианты без исключений: при ошибке возвращают NaN и записывают её код в error
+    double TryBinary(Token::TokenType operator_type, double left, double right, EvalError& error);
+    double TryUnary(Token::TokenType operator_type, double value, EvalError& error);
+    // Если errors не задан, ошибка в блоке бросает исключение; иначе для каждой
+    // строки без ошибки в errors[i] записывается код её первой ошибки
+    void BinaryBlock(Token::TokenType operator_type, double* left, const double* right, size_t count,
+                     EvalError* errors = nullptr);
+    void UnaryBlock(Token::TokenType operator_type, double* values, size_t count, EvalError* errors = nullptr);
+    // Блочные операторы без проверки результатов для отложенной проверки по флагам FPU;
+    // FactorialBlockUnchecked возвращает false, если в блоке есть недопустимый аргумент
+    void BinaryBlockUnchecked(Token::TokenType operator_type, double* left, const double* right, size_t count);
+    bool FactorialBlockUnchecked(double* values, size_t count);
+
+} //End of namespace Operations
@@ -0,0 +1,56 @@
+#pragma once
+#include "token.h"
+#include "ast.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Bytecode {
+
+    enum class OpCode : uint8_t {
+        PUSH_CONST,
+        LOAD_VAR,
+        ADD,
+        SUB,
+        MUL,
+        DIV,
+        POW,
+        NEG,
+        PLUS,
+        FACTORIAL,
+        CALL,
+        STORE_TEMP,
+        LOAD_TEMP
+    };
+
+    struct Instruction {
+        OpCode op;
+        uint32_t operand;
+        double value;
+    };
+
+    struct Program {
+        std::vector<Instruction> code;
+        std::vector<std::string> variables;
+        std::vector<double(*)(double)> functions;
+        std::vector<void(*)(double*, size_t)> block_functions;
+        size_t max_stack_depth = 0;
+        size_t temp_count = 0;
+        // Ошибки проверяются по флагам исключений FPU один раз на вычисление или блок
+        bool deferred_checks = false;
+    };
+
+    constexpr size_t kBatchBlockSize = 256;
+
+    Program Compile(const ASTNode& root, bool vectorized_math = true);
+    std::vector<double> BindVariables(const Program& program, const Token::Variables& vars);
+    double Execute(const Program& program, const double* slots);
+    // Вычисление без исключений: при ошибке возвращает NaN, а её код записывает в error
+    double Execute(const Program& program, const double* slots, Operations::EvalError& error);
+    double Execute(const Program& program, const Token::Variables& vars);
+    // Если задан errors (по элементу на строку), ошибки не бросаются: строка с
+    // ошибкой получает NaN, а в errors записывается код её первой ошибки
+    void ExecuteBatch(const Program& program, const double* const* columns, double* out, size_t row_count,
+                      Operations::EvalError* errors = nullptr);
+
+} //End of namespace Bytecode
@@ -1,9 +1,21 @@
 #pragma once
 #include "token.h"
+#include "compiled_expression.h"
+#include "function_registry.h"
 #include <string>
+#include <string_view>
 
 class Calculator {
 public:
     Calculator() {};
-    double Calculate(const std::string& expression, const Token::Variables& vars = {});
-};
\ No newline at end of file
+    // Ошибки сообщаются в порядке вычисления, как при обходе дерева: для x + 1/0
+    // без значения x - неизвестная переменная, а не ошибка деления
+    double Calculate(std::string_view expression, const Token::Variables& vars = {});
+    // Текст выражения не копируется и нужен только на время компиляции
+    CompiledExpression Compile(std::string_view expression, const CompileOptions& options = {}) const;
+    // Делает функцию доступной в выражениях, компилируемых после регистрации
+    void RegisterFunction(const std::string& name, double (*function)(double),
+                          void (*block_function)(double*, size_t) = nullptr);
+private:
+    FunctionRegistry functions_;
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include "expression_cache.h"
+#include "stream_evaluator.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/*
+    Сервер вычислений на Unix domain socket (только Linux, цикл событий
+    epoll в одном потоке). Клиент может отправлять запросы подряд, не
+    дожидаясь ответов; ответы приходят в порядке запросов. Кадр запроса и
+    ответа - длина полезной нагрузки (uint32, little-endian) и сама нагрузка.
+    Запрос - строка в формате --stream ("2 * x + y; x=3 y=1"). Ответ -
+    байт состояния, за которым следует:
+        0 - результат, 8 байт double (little-endian);
+        1 - текст сообщения об ошибке.
+    Скомпилированные выражения кэшируются общим для всех клиентов кэшем.
+    Соединение с кадром длиннее kMaxRequestSize закрывается после отправки
+    ответов на предшествующие ему запросы.
+*/
+class CalculatorServer {
+public:
+    static constexpr uint32_t kMaxRequestSize = 16 << 20;
+    static constexpr uint8_t kStatusOk = 0;
+    static constexpr uint8_t kStatusError = 1;
+
+    CalculatorServer(ExpressionCache& cache, std::string socket_path);
+    CalculatorServer(const CalculatorServer&) = delete;
+    CalculatorServer& operator=(const CalculatorServer&) = delete;
+    ~CalculatorServer();
+
+    // Обслуживает клиентов до вызова Stop
+    void Run();
+    // Можно вызывать из другого потока и из обработчика сигнала
+    void Stop();
+private:
+    struct Connection {
+        std::string input;
+        std::string output;
+        size_t output_sent = 0;
+        // Клиент закрыл передачу или прислал слишком длинный кадр: запросы
+        // больше не читаются, соединение закрывается после отправки ответов
+        bool eof = false;
+        uint32_t events = 0;
+    };
+
+    void Accept();
+    // Возвращает false, если соединение нужно закрыть
+    bool Receive(int fd, Connection& connection);
+    bool Send(int fd, Connection& connection);
+    bool HandleRequests(Connection& connection);
+    void UpdateEvents(int fd, Connection& connection);
+    void Close(int fd);
+    void Shutdown();
+private:
+    StreamEvaluator evaluator_;
+    std::string socket_path_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int stop_fd_ = -1;
+    bool bound_ = false;
+    std::map<int, Connection> connections_;
+};
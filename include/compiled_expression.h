@@ -0,0 +1,80 @@
+#pragma once
+#include "token.h"
+#include "ast.h"
+#include "bytecode.h"
+#include "jit.h"
+#include "optimizer.h"
+#include "thread_pool.h"
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+enum class Engine {
+    TREE_WALKER,
+    BYTECODE,
+    // Машинный код x86-64; при невозможности компиляции используется BYTECODE
+    JIT
+};
+
+struct CompileOptions {
+    Engine engine = Engine::BYTECODE;
+    // Отключает векторные реализации функций в пакетном режиме в пользу libm
+    bool strict_math = false;
+    // Сворачивает поддеревья без переменных в числа на этапе компиляции
+    bool fold_constants = true;
+    // Объединяет одинаковые поддеревья, чтобы каждое вычислялось один раз
+    bool eliminate_common_subexpressions = true;
+    // Байт-код проверяет ошибки по флагам FE_OVERFLOW, FE_INVALID и FE_DIVBYZERO
+    // один раз на вычисление или блок строк и лишь при их наличии повторяет
+    // вычисление с проверкой каждой операции; сбрасывает эти флаги FPU
+    bool deferred_fp_checks = false;
+};
+
+class CompiledExpression {
+public:
+    static constexpr size_t kParallelChunkRows = 16 * Bytecode::kBatchBlockSize;
+
+    double Evaluate(const Token::Variables& vars = {}) const;
+    double Evaluate(const double* slots, size_t slot_count) const;
+    void EvaluateBatch(const std::vector<const double*>& columns, double* out, size_t row_count) const;
+    void EvaluateBatch(const std::vector<const double*>& columns, double* out, size_t row_count,
+                       ThreadPool& pool) const;
+    /*
+        Вычисление без исключений на пути данных: строка с ошибкой получает
+        NaN, а её код (Operations::EvalError) записывается в error или errors[row].
+        Исключения бросаются только при неверных аргументах (число значений или
+        столбцов). Движок TREE_WALKER в этом режиме исполняет байт-код.
+    */
+    double TryEvaluate(const double* slots, size_t slot_count, Operations::EvalError& error) const;
+    void TryEvaluateBatch(const std::vector<const double*>& columns, double* out, Operations::EvalError* errors,
+                          size_t row_count) const;
+    void TryEvaluateBatch(const std::vector<const double*>& columns, double* out, Operations::EvalError* errors,
+                          size_t row_count, ThreadPool& pool) const;
+    const std::vector<std::string>& GetVariableNames() const;
+    size_t GetVariableSlot(const std::string& name) const;
+    std::vector<double> BindVariables(const Token::Variables& vars) const;
+    Engine GetEngine() const { return engine_; }
+    const Optimizer::CseStats& GetCseStats() const { return cse_stats_; }
+private:
+    void CheckSlotCount(size_t slot_count) const;
+    void CheckColumnCount(size_t column_count) const;
+    void RunBatch(const std::vector<const double*>& columns, double* out, Operations::EvalError* errors,
+                  size_t row_count) const;
+    void RunBatch(const std::vector<const double*>& columns, double* out, Operations::EvalError* errors,
+                  size_t row_count, ThreadPool& pool) const;
+    void EvaluateBatchJit(const std::vector<const double*>& columns, double* out, Operations::EvalError* errors,
+                          size_t row_count) const;
+private:
+    friend class Calculator;
+    CompiledExpression(std::shared_ptr<std::pmr::memory_resource> arena, std::shared_ptr<const ASTNode> root,
+                       const CompileOptions& options, const Optimizer::CseStats& cse_stats = {});
+private:
+    // Арена, в которой размещено дерево; объявлена первой, чтобы освобождаться после root_
+    std::shared_ptr<std::pmr::memory_resource> arena_;
+    std::shared_ptr<const ASTNode> root_;
+    std::shared_ptr<const Bytecode::Program> program_;
+    std::shared_ptr<const Jit::CompiledFunction> jit_;
+    Engine engine_;
+    Optimizer::CseStats cse_stats_;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include "compiled_expression.h"
+#include "file_io.h"
+#include "output_writer.h"
+#include "token.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    Вычисление одного выражения по строкам CSV-файла. Первая строка -
+    заголовок: столбцы с именами переменных выражения подставляются в них,
+    а переменные без столбца берутся из значений по умолчанию (--var).
+    Значения разбираются так же, как в --var, включая имена констант.
+    Каждая строка выводится без изменений с добавленным столбцом результата;
+    строка с ошибкой вычисления получает в нём сообщение "Error: ...", а
+    неверное значение во входных данных прерывает обработку. В двоичном
+    режиме выводятся только результаты (ошибка - NaN). Файл читается
+    блоками, и строки каждого блока вычисляются пакетно, поэтому расход
+    памяти не зависит от размера файла. Пустые строки пропускаются; поля в
+    кавычках поддерживаются, переводы строк внутри полей - нет.
+*/
+class CsvEvaluator {
+public:
+    explicit CsvEvaluator(const CompiledExpression& compiled, Token::Variables defaults = {},
+                          std::string result_column = "result");
+
+    void Run(FileIo::LineReader& reader, OutputWriter& writer);
+private:
+    void ProcessHeader(std::string_view line);
+    void ProcessRow(std::string_view line);
+    void EvaluateRows(OutputWriter& writer);
+private:
+    const CompiledExpression& compiled_;
+    Token::Variables defaults_;
+    std::string result_column_;
+    bool header_done_ = false;
+    size_t line_number_ = 0;
+    // Номер поля CSV для каждой ячейки переменной или kNoColumn
+    static constexpr size_t kNoColumn = static_cast<size_t>(-1);
+    std::vector<size_t> field_of_slot_;
+    std::vector<double> default_of_slot_;
+    // Строки текущего блока и значения переменных по столбцам
+    std::vector<std::string_view> rows_;
+    std::vector<std::vector<double>> columns_;
+    std::vector<std::string_view> fields_;
+    std::vector<double> results_;
+    std::vector<Operations::EvalError> errors_;
+};
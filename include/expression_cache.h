@@ -0,0 +1,45 @@
+#pragma once
+#include "calculator.h"
+#include "compiled_expression.h"
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+    Кэш скомпилированных выражений с вытеснением давно не использованных
+    (LRU). Ключом служит текст выражения; поиск не выделяет памяти.
+    Выражения, при компиляции которых возникла ошибка, не кэшируются.
+    Не потокобезопасен.
+*/
+class ExpressionCache {
+public:
+    static constexpr size_t kDefaultCapacity = 1024;
+
+    ExpressionCache(const Calculator& calc, const CompileOptions& options = {},
+                    size_t capacity = kDefaultCapacity);
+    ExpressionCache(const ExpressionCache&) = delete;
+    ExpressionCache& operator=(const ExpressionCache&) = delete;
+
+    // Ссылка действительна до следующего вызова Get
+    const CompiledExpression& Get(std::string_view expression);
+    size_t GetSize() const { return entries_.size(); }
+    size_t GetHits() const { return hits_; }
+    size_t GetMisses() const { return misses_; }
+private:
+    struct Entry {
+        std::string expression;
+        CompiledExpression compiled;
+    };
+private:
+    const Calculator& calc_;
+    CompileOptions options_;
+    size_t capacity_;
+    // Начало списка - последнее использованное выражение
+    std::list<Entry> entries_;
+    // Ключи ссылаются на строки в узлах списка, которые не перемещаются
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
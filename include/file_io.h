@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    Блочный ввод-вывод через файловые дескрипторы без буферизации
+    стандартной библиотеки. Ошибки бросают std::runtime_error.
+*/
+namespace FileIo {
+
+    // Владеющий файловый дескриптор
+    class File {
+    public:
+        static File OpenForReading(const std::string& path);
+        static File OpenForWriting(const std::string& path);
+
+        File() = default;
+        explicit File(int fd) : fd_(fd) {}
+        File(File&& other) noexcept;
+        File& operator=(File&& other) noexcept;
+        File(const File&) = delete;
+        File& operator=(const File&) = delete;
+        ~File();
+
+        int Get() const { return fd_; }
+    private:
+        int fd_ = -1;
+    };
+
+    /*
+        Файл, отображённый в память только для чтения, с подсказкой ядру о
+        последовательном чтении (madvise(MADV_SEQUENTIAL)): страницы читаются
+        с упреждением и не копируются в промежуточные буферы. На платформах
+        без mmap файл читается в память целиком.
+    */
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& path);
+        // Отображает открытый файл от текущей позиции до конца; дескриптор можно закрыть
+        explicit MappedFile(int fd);
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        std::string_view GetData() const { return std::string_view(data_ + offset_, size_ - offset_); }
+    private:
+        void Unmap();
+    private:
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+        size_t offset_ = 0;
+        // Содержимое файла, если отображение недоступно
+        std::string buffer_;
+    };
+
+    // Возвращает 0 в конце ввода; прерванные сигналом вызовы повторяются
+    size_t ReadSome(int fd, char* data, size_t size);
+    void WriteAll(int fd, const char* data, size_t size);
+
+    /*
+        Чтение блоками целых строк. Блок заканчивается переводом строки,
+        кроме последнего, если ввод им не заканчивается. Обычный файл
+        отображается в память, и блоки ссылаются прямо на отображение;
+        каналы и терминалы читаются в буфер, который растёт, если строка
+        в него не помещается. Блок действителен до следующего вызова.
+    */
+    class LineReader {
+    public:
+        static constexpr size_t kDefaultBufferSize = 1 << 20;
+
+        // Дескриптор остаётся во владении вызывающего
+        static LineReader Open(int fd, size_t buffer_size = kDefaultBufferSize);
+        static LineReader OpenFile(const std::string& path, size_t buffer_size = kDefaultBufferSize);
+
+        // Пустой блок означает конец ввода
+        std::string_view NextBlock();
+    private:
+        LineReader(File file, int fd, size_t buffer_size);
+        LineReader(MappedFile mapped, size_t buffer_size);
+        std::string_view NextMappedBlock();
+    private:
+        File file_;
+        int fd_ = -1;
+        std::unique_ptr<MappedFile> mapped_;
+        size_t mapped_position_ = 0;
+        size_t block_size_;
+        std::vector<char> buffer_;
+        size_t filled_ = 0;
+        // Длина последнего возвращённого блока; остаток переносится в начало буфера
+        size_t consumed_ = 0;
+        bool eof_ = false;
+    };
+
+    // Вызывает on_line для каждой строки блока без перевода строки
+    template <typename Callback>
+    void ForEachLine(std::string_view block, Callback&& on_line) {
+        while (!block.empty()) {
+            const size_t end = block.find('\n');
+            on_line(block.substr(0, end));
+            if (end == std::string_view::npos) {
+                break;
+            }
+            block.remove_prefix(end + 1);
+        }
+    }
+
+} //End of namespace FileIo
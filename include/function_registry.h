@@ -0,0 +1,29 @@
+#pragma once
+#include "token.h"
+#include <map>
+#include <string>
+#include <string_view>
+
+/*
+    Реестр функций одного аргумента. Встроенные функции берутся из
+    статической таблицы Token::FindFunction, дополнительные регистрируются
+    во время выполнения. Парсер разрешает имя функции один раз, и узел
+    дерева хранит указатели на её реализации, поэтому реестр не обязан
+    переживать скомпилированные выражения. Функции должны быть чистыми:
+    свёртка констант вызывает их при компиляции. Функция может сообщить об
+    ошибке исключением: вычисление передаёт его вызывающему коду при любом
+    движке (машинный код вызывает функции через перехватывающий переходник).
+*/
+class FunctionRegistry {
+public:
+    // Реестр, содержащий только встроенные функции
+    static const FunctionRegistry& Builtin();
+
+    // Добавляет или заменяет функцию; block_function - необязательная
+    // векторная реализация для пакетного режима
+    void Register(const std::string& name, double (*function)(double),
+                  void (*block_function)(double*, size_t) = nullptr);
+    const Token::FunctionEntry* Find(std::string_view name) const;
+private:
+    std::map<std::string, Token::FunctionEntry, std::less<>> functions_;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include "bytecode.h"
+#include <cstddef>
+#include <memory>
+
+namespace Jit {
+
+    /*
+        Машинный код x86-64, сгенерированный по программе байт-кода.
+        Скалярная функция вычисляет одну строку, пакетная - по две строки
+        за инструкцию (packed double SSE2). Ошибки вычислений не выбрасываются
+        из сгенерированного кода: скалярная функция возвращает NaN, пакетная
+        останавливается на неудачной паре строк, и вызывающая сторона
+        перевычисляет их интерпретатором, чтобы получить точное исключение.
+    */
+    class CompiledFunction {
+    public:
+        using ScalarEntry = double (*)(const double* slots);
+        using BatchEntry = size_t (*)(const double* const* columns, double* out, size_t begin, size_t end);
+
+        ~CompiledFunction();
+        CompiledFunction(const CompiledFunction&) = delete;
+        CompiledFunction& operator=(const CompiledFunction&) = delete;
+
+        // Возвращает nullptr, если программа содержит неподдерживаемые конструкции
+        static std::unique_ptr<CompiledFunction> Compile(const Bytecode::Program& program);
+
+        double Evaluate(const double* slots) const { return scalar_(slots); }
+        size_t EvaluateBatch(const double* const* columns, double* out, size_t begin, size_t end) const {
+            return batch_(columns, out, begin, end);
+        }
+        bool HasBatch() const { return batch_ != nullptr; }
+        size_t GetCodeSize() const { return size_; }
+    private:
+        CompiledFunction(void* memory, size_t size, ScalarEntry scalar, BatchEntry batch)
+            : memory_(memory), size_(size), scalar_(scalar), batch_(batch) {}
+    private:
+        void* memory_;
+        size_t size_;
+        ScalarEntry scalar_;
+        BatchEntry batch_;
+    };
+
+    bool IsSupported();
+
+} //End of namespace Jit
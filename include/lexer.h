@@ -1,15 +1,23 @@
 #pragma once
 #include "token.h"
+#include "function_registry.h"
+#include <memory_resource>
+#include <string_view>
 #include <vector>
 
 class Lexer {
 public:
-    explicit Lexer(const std::string& expression);
-    std::vector<Token::Token_Param> GetTokens();
+    // Вектор токенов выделяется из resource; имена идентификаторов ссылаются на expression,
+    // а функцией считается идентификатор, известный реестру functions
+    explicit Lexer(std::string_view expression, const FunctionRegistry& functions = FunctionRegistry::Builtin(),
+                   std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    Token::Tokens GetTokens();
 private:
-    void HandleUnaryOperators(std::vector<Token::Token_Param>& tokens);
+    // Разбирает число, начинающееся с pos, и возвращает позицию за ним
+    size_t ScanNumber(size_t pos, Token::Tokens& tokens) const;
+    void HandleUnaryOperators(Token::Tokens& tokens);
 private:
-    Token::Constants constants_;
-    Token::Functions functions_;
-    const std::string& expression_;
+    std::string_view expression_;
+    const FunctionRegistry& functions_;
+    std::pmr::memory_resource* resource_;
 };
\ No newline at end of file
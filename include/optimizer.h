@@ -0,0 +1,23 @@
+#pragma once
+#include "ast.h"
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace Optimizer {
+
+    struct CseStats {
+        size_t tree_nodes = 0;
+        size_t dag_nodes = 0;
+    };
+
+    // Результат целиком строится в resource (обычно это арена компилируемого выражения)
+    // и не ссылается на узлы root, которые можно освободить после прохода
+    std::shared_ptr<const ASTNode> FoldConstants(const ASTNode& root,
+                                                 std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    std::shared_ptr<const ASTNode> EliminateCommonSubexpressions(const ASTNode& root,
+                                                                 CseStats* stats = nullptr,
+                                                                 std::pmr::memory_resource* resource =
+                                                                     std::pmr::get_default_resource());
+
+} //End of namespace Optimizer
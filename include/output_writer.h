@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/*
+    Буферизованный вывод результатов потокового и пакетного режимов.
+    Числа форматируются std::to_chars без учёта локали: по умолчанию
+    кратчайшей записью, из которой double восстанавливается точно, или с
+    заданным числом значащих цифр. В двоичном режиме число записывается
+    восемью байтами double в порядке байт машины, а текст не выводится.
+    Буфер сбрасывается только вызовом Flush на границе блока данных.
+*/
+class OutputWriter {
+public:
+    static constexpr size_t kBufferSize = 1 << 20;
+    // Кратчайшая запись вместо фиксированного числа значащих цифр
+    static constexpr int kShortest = 0;
+
+    explicit OutputWriter(int fd, int precision = kShortest, bool binary = false);
+
+    // Дописывает текстовую запись числа к out
+    static void AppendNumber(std::string& out, double value, int precision = kShortest);
+
+    bool IsBinary() const { return binary_; }
+    void WriteNumber(double value);
+    void WriteText(std::string_view text) {
+        if (!binary_) {
+            buffer_.append(text.data(), text.size());
+        }
+    }
+    void Flush();
+private:
+    int fd_;
+    int precision_;
+    bool binary_;
+    std::string buffer_;
+};
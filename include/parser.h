@@ -1,17 +1,41 @@
 #pragma once
 #include "token.h"
 #include "ast.h"
+#include "function_registry.h"
 #include <vector>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
 
 class Parser {
 public:
-    Parser(const std::vector<Token::Token_Param>& tokens);
-    std::unique_ptr<ASTNode> Parse();
+    /*
+        Наибольшая вложенность выражения: скобок, а также правых операндов,
+        унарных операторов и аргументов функций в дереве. Проходы по дереву
+        обрабатывают их рекурсивно, и более глубокое выражение исчерпало бы
+        стек, поэтому оно отвергается ошибкой разбора. Длина цепочек вида
+        a + b + c + ... не ограничена: их проходы обходят циклом.
+    */
+    static constexpr size_t kMaxDepth = 1000;
+
+    // expression - исходная строка, из которой читаются имена идентификаторов;
+    // вызовы функций разрешаются через functions; узлы дерева выделяются
+    // из resource, который должен пережить результат Parse
+    Parser(const Token::Tokens& tokens, std::string_view expression,
+           const FunctionRegistry& functions = FunctionRegistry::Builtin(),
+           std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    std::shared_ptr<const ASTNode> Parse();
     
 private:
-    const std::vector<Token::Token_Param>& tokens_;
+    const Token::Tokens& tokens_;
+    std::string_view expression_;
+    const FunctionRegistry& functions_;
+    std::pmr::memory_resource* resource_;
     size_t current_pos_ = 0;
+    // Вложенность скобок и вызовов функций в текущей точке разбора
+    size_t nesting_ = 0;
+    // Вложенность последнего разобранного поддерева без учёта левых цепочек
+    size_t depth_ = 0;
     
     const Token::Token_Param& Peek() const;
     const Token::Token_Param& Advance();
@@ -19,14 +43,17 @@ private:
     void Match(Token::TokenType type, const std::string& message);
     bool Check(Token::TokenType type) const;
     bool IsAtEnd() const;
+    // Вложенность узла над операндом заданной вложенности; бросает исключение при превышении kMaxDepth
+    static size_t Nest(size_t operand_depth);
+    void EnterNesting();
     
-    std::unique_ptr<ASTNode> ParseExpression();
-    std::unique_ptr<ASTNode> ParsePrimaryExpr();
-    std::unique_ptr<ASTNode> ParseUnaryOp();
-    std::unique_ptr<ASTNode> ParsePowerOp();
-    std::unique_ptr<ASTNode> ParseMultiplicativeOp();
-    std::unique_ptr<ASTNode> ParseAdditiveOp();
-    std::unique_ptr<ASTNode> ParseFunctionCall(const std::string& name);
+    std::shared_ptr<const ASTNode> ParseExpression();
+    std::shared_ptr<const ASTNode> ParsePrimaryExpr();
+    std::shared_ptr<const ASTNode> ParseUnaryOp();
+    std::shared_ptr<const ASTNode> ParsePowerOp();
+    std::shared_ptr<const ASTNode> ParseMultiplicativeOp();
+    std::shared_ptr<const ASTNode> ParseAdditiveOp();
+    std::shared_ptr<const ASTNode> ParseFunctionCall(std::string_view name);
     
     bool IsMatchingBracket(Token::TokenType open, Token::TokenType close) const;
 };
\ No newline at end of file
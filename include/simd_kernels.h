@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+
+namespace Simd {
+
+    /*
+        Векторные ядра арифметики для пакетного вычисления. Результат
+        записывается на место левого операнда; возвращаемое значение
+        сообщает, все ли результаты блока конечны.
+    */
+    bool Add(double* left, const double* right, size_t count);
+    bool Subtract(double* left, const double* right, size_t count);
+    bool Multiply(double* left, const double* right, size_t count);
+    bool Divide(double* left, const double* right, size_t count);
+    void Negate(double* values, size_t count);
+    bool AllFinite(const double* values, size_t count);
+
+    /*
+        Синус и косинус на месте. Аргумент приводится к [-pi/4, pi/4]
+        трёхчленным разложением pi/2 (Коди-Уэйт), после чего вычисляются
+        минимаксные многочлены fdlibm. Измеренная погрешность относительно libm:
+        не более 1 ULP при |x| <= 100 и не более 2 ULP при |x| <= 2^20 * pi/2.
+        Остальные аргументы, включая inf и NaN, вычисляются через libm.
+    */
+    void Sin(double* values, size_t count);
+    void Cos(double* values, size_t count);
+
+    /*
+        Заменяет values[i] на table[values[i]], пока значения являются целыми
+        числами из [0, table_size). Возвращает число обработанных элементов:
+        начиная с возвращённой позиции значения не изменены, и среди них есть
+        недопустимый индекс.
+    */
+    size_t Gather(double* values, size_t count, const double* table, size_t table_size);
+
+    const char* GetInstructionSet();
+
+} //End of namespace Simd
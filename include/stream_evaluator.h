@@ -0,0 +1,32 @@
+#pragma once
+#include "expression_cache.h"
+#include "file_io.h"
+#include "output_writer.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    Потоковое вычисление: каждая строка ввода содержит выражение и,
+    необязательно, значения переменных после точки с запятой:
+        2 * x + y; x=1 y=PI
+    На каждую строку выводится одна строка с результатом или с сообщением
+    "Error: ..." (в двоичном режиме - NaN) - ошибка в строке не прерывает
+    поток. Ввод читается крупными блоками, а вывод сбрасывается после
+    каждого блока, поэтому интерактивный клиент получает ответы без
+    ожидания конца ввода.
+*/
+class StreamEvaluator {
+public:
+    explicit StreamEvaluator(ExpressionCache& cache);
+
+    // Обрабатывает поток до конца ввода; ошибки ввода-вывода бросают исключение
+    void Run(FileIo::LineReader& reader, OutputWriter& writer);
+    // Вычисляет одну строку; ошибка в ней бросает исключение
+    double EvaluateLine(std::string_view line);
+private:
+    ExpressionCache& cache_;
+    // Ячейки переменных переиспользуются между строками
+    std::vector<double> slots_;
+    std::vector<char> bound_;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+    Пул потоков с перехватом работы: каждый поток берёт задачи из своей
+    очереди, а опустев, забирает задачи с конца чужих очередей.
+*/
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetThreadCount() const { return workers_.size(); }
+    void ParallelFor(size_t task_count, const std::function<void(size_t)>& task);
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void WorkerLoop(size_t worker_index);
+    bool PopTask(size_t worker_index, size_t& task_index);
+    bool StealTask(size_t worker_index, size_t& task_index);
+    void RunTask(size_t task_index);
+private:
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::atomic<const std::function<void(size_t)>*> task_{nullptr};
+    size_t generation_ = 0;
+    std::atomic<size_t> pending_{0};
+    bool stop_ = false;
+
+    std::mutex run_mutex_;
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+    size_t error_index_ = 0;
+};
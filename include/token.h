@@ -1,8 +1,11 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
+#include <cstdint>
 #include <map>
+#include <memory_resource>
 
 namespace Token{
 
@@ -27,20 +30,53 @@ namespace Token{
         FUNCTION
     };
 
+    /*
+        Компактный токен (16 байт, без выделений памяти): числа и константы
+        хранят значение, а идентификаторы - длину имени, само имя читается
+        из исходного выражения начиная с position. У операторов и скобок
+        полезной нагрузки нет.
+    */
     struct Token_Param{
         TokenType type;
-        std::variant<double, std::string> value;
-        size_t position;
+        uint32_t position;
+        union {
+            double number;
+            uint32_t length;
+        };
+
+        std::string_view GetText(std::string_view expression) const {
+            return expression.substr(position, length);
+        }
     };
+    static_assert(sizeof(Token_Param) == 16, "Token_Param is expected to stay compact");
 
+    // Токены выражения размещаются в арене компиляции
+    using Tokens = std::pmr::vector<Token_Param>;
     //using Variables = std::map<std::string, double>;
-    using Variables = std::map<std::string, std::variant<double, std::string>>;
-    using Constants = std::map<std::string, double>;
-    using Functions = std::map<std::string, double(*)(double)>;
-    using FunctionArgs = std::vector<double>;
+    // Прозрачный компаратор позволяет искать по std::string_view без копирования имени
+    using Variables = std::map<std::string, std::variant<double, std::string>, std::less<>>;
+
+    struct ConstantEntry {
+        std::string_view name;
+        double value;
+    };
+
+    struct FunctionEntry {
+        std::string_view name;
+        double (*function)(double);
+        // Векторная реализация для пакетного режима или nullptr
+        void (*block_function)(double*, size_t);
+    };
+
+    /*
+        Встроенные константы и функции хранятся в статических таблицах с
+        совершенным хешированием, построенных на этапе компиляции: поиск
+        выполняется за O(1) без выделений памяти. При отсутствии имени
+        возвращается nullptr.
+    */
+    const ConstantEntry* FindConstant(std::string_view name);
+    const FunctionEntry* FindFunction(std::string_view name);
 
-    Constants GetDefaultConstants();
-    Functions GetDefaultFunctions();
     bool IsOperator(TokenType type);
 
 } //End of namespace Token
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include "token.h"
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+/*
+    Разбор значений переменных вида name=value из командной строки,
+    входных потоков и CSV. Значение, начинающееся с буквы, - имя константы
+    (например, PI), которое разрешается только при использовании переменной
+    в выражении; любое другое значение должно целиком быть числом.
+*/
+namespace VariableParser {
+
+    using Value = std::variant<double, std::string_view>;
+
+    struct Binding {
+        std::string_view name;
+        Value value;
+    };
+
+    // Строковое значение ссылается на text; при ошибке сообщение содержит context
+    Value ParseValue(std::string_view text, std::string_view context);
+    // Разбирает одну пару; name и строковое значение ссылаются на pair
+    Binding ParseBinding(std::string_view pair);
+    // Число или значение константы; для неизвестного имени бросает исключение
+    double ResolveValue(const Value& value);
+    Token::Variables ParseVariables(const std::vector<std::string>& raw_vars);
+
+} //End of namespace VariableParser
@@ -0,0 +1,73 @@
+#include "arrow_evaluator.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+ArrowEvaluator::ArrowEvaluator(const CompiledExpression& compiled, Token::Variables defaults,
+                               std::string result_column)
+    : compiled_(compiled), defaults_(std::move(defaults)), result_column_(std::move(result_column)) {}
+
+void ArrowEvaluator::Run(const Arrow::Reader& reader, int output_fd) {
+    const std::vector<std::string>& column_names = reader.GetColumnNames();
+    const std::vector<std::string>& names = compiled_.GetVariableNames();
+    constexpr size_t kNoColumn = static_cast<size_t>(-1);
+    std::vector<size_t> column_of_slot(names.size(), kNoColumn);
+    std::vector<double> default_of_slot(names.size(), 0.0);
+    for (size_t slot = 0; slot < names.size(); ++slot) {
+        auto it = std::find(column_names.begin(), column_names.end(), names[slot]);
+        if (it != column_names.end()) {
+            column_of_slot[slot] = static_cast<size_t>(it - column_names.begin());
+        } else if (defaults_.find(names[slot]) != defaults_.end()) {
+            default_of_slot[slot] = Operations::ResolveVariable(names[slot], defaults_);
+        } else {
+            throw std::runtime_error("No Arrow column or --var value for variable: " + names[slot]);
+        }
+    }
+
+    std::vector<std::string> output_names = column_names;
+    output_names.push_back(result_column_);
+    Arrow::Writer writer(output_fd, std::move(output_names));
+    std::vector<std::vector<double>> default_columns(names.size());
+    std::vector<const double*> columns(names.size());
+    std::vector<double> results;
+    std::vector<Operations::EvalError> errors;
+    std::vector<uint8_t> validity;
+    for (size_t index = 0; index < reader.GetBatchCount(); ++index) {
+        Arrow::RecordBatch batch = reader.GetBatch(index);
+        const size_t row_count = batch.row_count;
+        for (size_t slot = 0; slot < names.size(); ++slot) {
+            if (column_of_slot[slot] != kNoColumn) {
+                columns[slot] = batch.columns[column_of_slot[slot]];
+            } else {
+                default_columns[slot].assign(row_count, default_of_slot[slot]);
+                columns[slot] = default_columns[slot].data();
+            }
+        }
+        results.resize(row_count);
+        errors.resize(row_count);
+        compiled_.TryEvaluateBatch(columns, results.data(), errors.data(), row_count);
+
+        // Результат пропущен, если пропущено значение переменной или вычисление дало ошибку
+        validity.assign((row_count + 7) / 8, 0xFF);
+        bool has_nulls = false;
+        for (size_t slot = 0; slot < names.size(); ++slot) {
+            const uint8_t* mask = column_of_slot[slot] != kNoColumn ? batch.validity[column_of_slot[slot]] : nullptr;
+            if (mask != nullptr) {
+                for (size_t byte = 0; byte < validity.size(); ++byte) {
+                    validity[byte] &= mask[byte];
+                }
+                has_nulls = true;
+            }
+        }
+        for (size_t row = 0; row < row_count; ++row) {
+            if (errors[row] != Operations::EvalError::NONE) {
+                validity[row / 8] &= static_cast<uint8_t>(~(1u << (row % 8)));
+                has_nulls = true;
+            }
+        }
+        batch.columns.push_back(results.data());
+        batch.validity.push_back(has_nulls ? validity.data() : nullptr);
+        writer.WriteBatch(row_count, batch.columns, batch.validity);
+    }
+    writer.Finish();
+}
@@ -0,0 +1,538 @@
+#include "arrow_ipc.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace Arrow {
+
+    namespace {
+
+        constexpr std::string_view kMagic("ARROW1", 6);
+        constexpr uint32_t kContinuation = 0xFFFFFFFF;
+        // Значения перечислений из Schema.fbs и Message.fbs
+        constexpr int16_t kMetadataVersionV5 = 4;
+        constexpr uint8_t kHeaderSchema = 1;
+        constexpr uint8_t kHeaderRecordBatch = 3;
+        constexpr uint8_t kTypeFloatingPoint = 3;
+        constexpr int16_t kPrecisionDouble = 2;
+        constexpr size_t kFieldNodeSize = 16;
+        constexpr size_t kBufferSize = 16;
+        constexpr size_t kBlockSize = 24;
+
+        [[noreturn]] void Invalid(const std::string& what) {
+            throw std::runtime_error("Invalid Arrow file: " + what);
+        }
+
+        constexpr size_t AlignUp(size_t value, size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        template <typename T>
+        T Load(std::string_view buffer, size_t position) {
+            if (position > buffer.size() || buffer.size() - position < sizeof(T)) {
+                Invalid("offset out of bounds");
+            }
+            T value;
+            std::memcpy(&value, buffer.data() + position, sizeof(T));
+            return value;
+        }
+
+        /*
+            Чтение таблиц FlatBuffers: таблица начинается со смещения до своей
+            vtable, которая хранит положения полей; отсутствующее поле имеет
+            значение по умолчанию. Ссылки на вложенные объекты отсчитываются
+            от положения самой ссылки. Все обращения проверяют границы буфера.
+        */
+        class FlatVector;
+
+        class FlatTable {
+        public:
+            FlatTable(std::string_view buffer, size_t position) : buffer_(buffer), position_(position) {
+                const int64_t vtable = static_cast<int64_t>(position) - Load<int32_t>(buffer, position);
+                if (vtable < 0 || static_cast<uint64_t>(vtable) >= buffer.size()) {
+                    Invalid("vtable out of bounds");
+                }
+                vtable_ = static_cast<size_t>(vtable);
+                vtable_size_ = Load<uint16_t>(buffer, vtable_);
+            }
+
+            static FlatTable Root(std::string_view buffer) {
+                return FlatTable(buffer, Load<uint32_t>(buffer, 0));
+            }
+
+            bool Has(uint16_t field) const {
+                return FieldPosition(field) != 0;
+            }
+
+            template <typename T>
+            T Scalar(uint16_t field, T default_value) const {
+                const size_t position = FieldPosition(field);
+                return position != 0 ? Load<T>(buffer_, position) : default_value;
+            }
+
+            FlatTable Table(uint16_t field, const char* name) const {
+                const size_t position = FieldPosition(field);
+                if (position == 0) {
+                    Invalid(std::string("missing ") + name);
+                }
+                return FlatTable(buffer_, Follow(position));
+            }
+
+            std::string_view String(uint16_t field) const {
+                const size_t position = FieldPosition(field);
+                if (position == 0) {
+                    return {};
+                }
+                const size_t string = Follow(position);
+                const uint32_t length = Load<uint32_t>(buffer_, string);
+                if (buffer_.size() - string - sizeof(uint32_t) < length) {
+                    Invalid("string out of bounds");
+                }
+                return buffer_.substr(string + sizeof(uint32_t), length);
+            }
+
+            FlatVector Vector(uint16_t field, size_t element_size) const;
+        private:
+            size_t FieldPosition(uint16_t field) const {
+                const size_t entry = sizeof(uint16_t) * (2 + field);
+                if (entry + sizeof(uint16_t) > vtable_size_) {
+                    return 0;
+                }
+                const uint16_t offset = Load<uint16_t>(buffer_, vtable_ + entry);
+                return offset != 0 ? position_ + offset : 0;
+            }
+
+            size_t Follow(size_t position) const {
+                return position + Load<uint32_t>(buffer_, position);
+            }
+        private:
+            std::string_view buffer_;
+            size_t position_;
+            size_t vtable_;
+            uint16_t vtable_size_;
+        };
+
+        // Вектор структур фиксированного размера или ссылок на таблицы
+        class FlatVector {
+        public:
+            FlatVector() = default;
+            FlatVector(std::string_view buffer, size_t position, size_t element_size)
+                : buffer_(buffer), element_size_(element_size) {
+                size_ = Load<uint32_t>(buffer, position);
+                data_ = position + sizeof(uint32_t);
+                if ((buffer.size() - data_) / element_size < size_) {
+                    Invalid("vector out of bounds");
+                }
+            }
+
+            size_t GetSize() const { return size_; }
+
+            template <typename T>
+            T Get(size_t index, size_t offset) const {
+                return Load<T>(buffer_, data_ + index * element_size_ + offset);
+            }
+
+            FlatTable TableAt(size_t index) const {
+                const size_t position = data_ + index * element_size_;
+                return FlatTable(buffer_, position + Load<uint32_t>(buffer_, position));
+            }
+        private:
+            std::string_view buffer_;
+            size_t data_ = 0;
+            size_t size_ = 0;
+            size_t element_size_ = 1;
+        };
+
+        FlatVector FlatTable::Vector(uint16_t field, size_t element_size) const {
+            const size_t position = FieldPosition(field);
+            return position != 0 ? FlatVector(buffer_, Follow(position), element_size) : FlatVector();
+        }
+
+        /*
+            Построение FlatBuffers от начала к концу: таблица записывается
+            раньше вложенных объектов, а ссылки на них заполняются после их
+            записи, поэтому смещения всегда положительны. vtable помещается
+            непосредственно перед своей таблицей.
+        */
+        class FlatBuilder {
+        public:
+            using ChildWriter = std::function<size_t(FlatBuilder&)>;
+
+            struct Field {
+                uint16_t id;
+                // Размер скаляра в байтах; 0 - ссылка на объект, записываемый child
+                uint8_t size;
+                uint64_t value;
+                ChildWriter child;
+            };
+
+            std::string Finish(const ChildWriter& root) {
+                buffer_.assign(sizeof(uint32_t), '\0');
+                const size_t root_position = root(*this);
+                Store<uint32_t>(0, static_cast<uint32_t>(root_position));
+                return std::move(buffer_);
+            }
+
+            size_t AddTable(const std::vector<Field>& fields) {
+                // Поля размещаются по убыванию размера, чтобы не было пропусков на выравнивание
+                std::vector<size_t> order(fields.size());
+                for (size_t i = 0; i < order.size(); ++i) {
+                    order[i] = i;
+                }
+                std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                    return FieldSize(fields[a]) > FieldSize(fields[b]);
+                });
+                std::vector<uint16_t> offsets(fields.size());
+                size_t table_size = sizeof(int32_t);
+                size_t alignment = sizeof(int32_t);
+                uint16_t field_count = 0;
+                for (size_t index : order) {
+                    const size_t size = FieldSize(fields[index]);
+                    table_size = AlignUp(table_size, size);
+                    offsets[index] = static_cast<uint16_t>(table_size);
+                    table_size += size;
+                    alignment = std::max(alignment, size);
+                    field_count = std::max<uint16_t>(field_count, fields[index].id + 1);
+                }
+
+                Pad(sizeof(uint16_t));
+                const size_t vtable = buffer_.size();
+                std::vector<uint16_t> entries(2 + field_count, 0);
+                entries[0] = static_cast<uint16_t>(entries.size() * sizeof(uint16_t));
+                entries[1] = static_cast<uint16_t>(table_size);
+                for (size_t i = 0; i < fields.size(); ++i) {
+                    entries[2 + fields[i].id] = offsets[i];
+                }
+                Append(entries.data(), entries.size() * sizeof(uint16_t));
+
+                Pad(alignment);
+                const size_t table = buffer_.size();
+                buffer_.resize(table + table_size, '\0');
+                Store<int32_t>(table, static_cast<int32_t>(table - vtable));
+                for (size_t i = 0; i < fields.size(); ++i) {
+                    if (fields[i].size != 0) {
+                        // Младшие байты значения (порядок байт little-endian)
+                        std::memcpy(&buffer_[table + offsets[i]], &fields[i].value, fields[i].size);
+                    }
+                }
+                for (size_t i = 0; i < fields.size(); ++i) {
+                    if (fields[i].size == 0) {
+                        const size_t reference = table + offsets[i];
+                        const size_t child = fields[i].child(*this);
+                        Store<uint32_t>(reference, static_cast<uint32_t>(child - reference));
+                    }
+                }
+                return table;
+            }
+
+            size_t AddString(std::string_view text) {
+                Pad(sizeof(uint32_t));
+                const size_t position = buffer_.size();
+                const uint32_t length = static_cast<uint32_t>(text.size());
+                Append(&length, sizeof(length));
+                Append(text.data(), text.size());
+                buffer_.push_back('\0');
+                return position;
+            }
+
+            // Элементы структур выравниваются на 8 байт
+            size_t AddStructVector(const void* data, size_t count, size_t element_size) {
+                Pad(sizeof(uint32_t));
+                if ((buffer_.size() + sizeof(uint32_t)) % sizeof(uint64_t) != 0) {
+                    Pad(sizeof(uint64_t));
+                    buffer_.resize(buffer_.size() + sizeof(uint32_t), '\0');
+                }
+                const size_t position = buffer_.size();
+                const uint32_t length = static_cast<uint32_t>(count);
+                Append(&length, sizeof(length));
+                if (count != 0) {
+                    Append(data, count * element_size);
+                }
+                return position;
+            }
+
+            size_t AddTableVector(const std::vector<ChildWriter>& tables) {
+                Pad(sizeof(uint32_t));
+                const size_t position = buffer_.size();
+                const uint32_t length = static_cast<uint32_t>(tables.size());
+                Append(&length, sizeof(length));
+                buffer_.resize(buffer_.size() + tables.size() * sizeof(uint32_t), '\0');
+                for (size_t i = 0; i < tables.size(); ++i) {
+                    const size_t reference = position + sizeof(uint32_t) * (i + 1);
+                    const size_t child = tables[i](*this);
+                    Store<uint32_t>(reference, static_cast<uint32_t>(child - reference));
+                }
+                return position;
+            }
+        private:
+            static size_t FieldSize(const Field& field) {
+                return field.size != 0 ? field.size : sizeof(uint32_t);
+            }
+
+            void Pad(size_t alignment) {
+                buffer_.resize(AlignUp(buffer_.size(), alignment), '\0');
+            }
+
+            void Append(const void* data, size_t size) {
+                buffer_.append(static_cast<const char*>(data), size);
+            }
+
+            template <typename T>
+            void Store(size_t position, T value) {
+                std::memcpy(&buffer_[position], &value, sizeof(T));
+            }
+        private:
+            std::string buffer_;
+        };
+
+        using ChildWriter = FlatBuilder::ChildWriter;
+
+        ChildWriter SchemaWriter(const std::vector<std::string>& column_names) {
+            return [&column_names](FlatBuilder& builder) {
+                std::vector<ChildWriter> fields;
+                for (const std::string& name : column_names) {
+                    fields.push_back([&name](FlatBuilder& builder) {
+                        return builder.AddTable({
+                            {0, 0, 0, [&name](FlatBuilder& builder) { return builder.AddString(name); }},
+                            {1, 1, 1, nullptr},  // nullable
+                            {2, 1, kTypeFloatingPoint, nullptr},
+                            {3, 0, 0, [](FlatBuilder& builder) {
+                                return builder.AddTable({{0, 2, static_cast<uint64_t>(kPrecisionDouble), nullptr}});
+                            }},
+                            {5, 0, 0, [](FlatBuilder& builder) { return builder.AddTableVector({}); }},  // children
+                        });
+                    });
+                }
+                return builder.AddTable({
+                    {1, 0, 0, [&fields](FlatBuilder& builder) { return builder.AddTableVector(fields); }},
+                });
+            };
+        }
+
+        std::string MessageMetadata(uint8_t header_type, const ChildWriter& header, uint64_t body_length) {
+            return FlatBuilder().Finish([&](FlatBuilder& builder) {
+                return builder.AddTable({
+                    {0, 2, static_cast<uint64_t>(kMetadataVersionV5), nullptr},
+                    {1, 1, header_type, nullptr},
+                    {2, 0, 0, header},
+                    {3, 8, body_length, nullptr},
+                });
+            });
+        }
+
+    } //End of anonymous namespace
+
+    Reader::Reader(const std::string& path) : file_(path) {
+        const std::string_view data = file_.GetData();
+        if (data.size() < 2 * AlignUp(kMagic.size(), 8) + sizeof(int32_t) ||
+            data.substr(0, kMagic.size()) != kMagic || data.substr(data.size() - kMagic.size()) != kMagic) {
+            Invalid("missing ARROW1 magic");
+        }
+        const size_t footer_end = data.size() - kMagic.size() - sizeof(int32_t);
+        const int32_t footer_length = Load<int32_t>(data, footer_end);
+        if (footer_length <= 0 || static_cast<size_t>(footer_length) > footer_end - AlignUp(kMagic.size(), 8)) {
+            Invalid("bad footer length");
+        }
+        const FlatTable footer = FlatTable::Root(data.substr(footer_end - footer_length, footer_length));
+
+        const FlatTable schema = footer.Table(1, "schema");
+        if (schema.Scalar<int16_t>(0, 0) != 0) {
+            Invalid("big-endian files are not supported");
+        }
+        const FlatVector fields = schema.Vector(1, sizeof(uint32_t));
+        for (size_t i = 0; i < fields.GetSize(); ++i) {
+            const FlatTable field = fields.TableAt(i);
+            const std::string_view name = field.String(0);
+            if (field.Scalar<uint8_t>(2, 0) != kTypeFloatingPoint ||
+                field.Table(3, "field type").Scalar<int16_t>(0, 0) != kPrecisionDouble || field.Has(4)) {
+                throw std::runtime_error("Arrow column " + std::string(name) + " is not float64");
+            }
+            column_names_.emplace_back(name);
+        }
+
+        const FlatVector batches = footer.Vector(3, kBlockSize);
+        for (size_t i = 0; i < batches.GetSize(); ++i) {
+            Block block;
+            block.offset = batches.Get<uint64_t>(i, 0);
+            block.metadata_length = batches.Get<uint32_t>(i, 8);
+            block.body_length = batches.Get<uint64_t>(i, 16);
+            if (block.offset > data.size() || data.size() - block.offset < block.metadata_length ||
+                data.size() - block.offset - block.metadata_length < block.body_length) {
+                Invalid("record batch out of bounds");
+            }
+            batches_.push_back(block);
+        }
+    }
+
+    RecordBatch Reader::GetBatch(size_t index) const {
+        const std::string_view data = file_.GetData();
+        const Block& block = batches_.at(index);
+        // Файлы до версии 0.15 не содержат маркера продолжения перед длиной метаданных
+        size_t metadata = block.offset + sizeof(uint32_t);
+        if (Load<uint32_t>(data, block.offset) == kContinuation) {
+            metadata += sizeof(uint32_t);
+        }
+        const size_t metadata_end = block.offset + block.metadata_length;
+        if (metadata > metadata_end) {
+            Invalid("bad message length");
+        }
+        const FlatTable message = FlatTable::Root(data.substr(metadata, metadata_end - metadata));
+        if (message.Scalar<uint8_t>(1, 0) != kHeaderRecordBatch) {
+            Invalid("block is not a record batch");
+        }
+        const FlatTable batch = message.Table(2, "record batch");
+        if (batch.Has(3)) {
+            throw std::runtime_error("Compressed Arrow record batches are not supported");
+        }
+
+        RecordBatch result;
+        const int64_t row_count = batch.Scalar<int64_t>(0, 0);
+        if (row_count < 0) {
+            Invalid("negative row count");
+        }
+        result.row_count = static_cast<size_t>(row_count);
+        const FlatVector nodes = batch.Vector(1, kFieldNodeSize);
+        const FlatVector buffers = batch.Vector(2, kBufferSize);
+        if (nodes.GetSize() != column_names_.size() || buffers.GetSize() != 2 * column_names_.size()) {
+            Invalid("record batch does not match schema");
+        }
+        const std::string_view body = data.substr(metadata_end, block.body_length);
+        for (size_t column = 0; column < column_names_.size(); ++column) {
+            // Буферы столбца: маска допустимости и значения
+            const uint8_t* validity = nullptr;
+            if (nodes.Get<int64_t>(column, 8) != 0) {
+                const uint64_t offset = buffers.Get<uint64_t>(2 * column, 0);
+                const uint64_t length = buffers.Get<uint64_t>(2 * column, 8);
+                if (offset > body.size() || body.size() - offset < length || length < (result.row_count + 7) / 8) {
+                    Invalid("validity buffer out of bounds");
+                }
+                validity = reinterpret_cast<const uint8_t*>(body.data() + offset);
+            }
+            result.validity.push_back(validity);
+            const uint64_t offset = buffers.Get<uint64_t>(2 * column + 1, 0);
+            const uint64_t length = buffers.Get<uint64_t>(2 * column + 1, 8);
+            if (offset > body.size() || body.size() - offset < length || length / sizeof(double) < result.row_count) {
+                Invalid("column buffer out of bounds");
+            }
+            const char* values = body.data() + offset;
+            if (reinterpret_cast<uintptr_t>(values) % alignof(double) != 0) {
+                Invalid("column buffer is not aligned");
+            }
+            result.columns.push_back(reinterpret_cast<const double*>(values));
+        }
+        return result;
+    }
+
+    Writer::Writer(int fd, std::vector<std::string> column_names)
+        : fd_(fd), column_names_(std::move(column_names)) {
+        Write(kMagic.data(), kMagic.size());
+        WritePadding(AlignUp(kMagic.size(), 8) - kMagic.size());
+        WriteMessage(MessageMetadata(kHeaderSchema, SchemaWriter(column_names_), 0), 0, nullptr);
+    }
+
+    void Writer::WriteBatch(size_t row_count, const std::vector<const double*>& columns,
+                            const std::vector<const uint8_t*>& validity) {
+        if (columns.size() != column_names_.size() || validity.size() != column_names_.size()) {
+            throw std::runtime_error("Arrow record batch does not match schema");
+        }
+        struct FieldNode { int64_t length; int64_t null_count; };
+        struct Buffer { int64_t offset; int64_t length; };
+        std::vector<FieldNode> nodes;
+        std::vector<Buffer> buffers;
+        const size_t bitmap_size = (row_count + 7) / 8;
+        const size_t values_size = row_count * sizeof(double);
+        int64_t body_length = 0;
+        for (size_t column = 0; column < columns.size(); ++column) {
+            int64_t null_count = 0;
+            if (validity[column] != nullptr) {
+                for (size_t row = 0; row < row_count; ++row) {
+                    null_count += (validity[column][row / 8] >> (row % 8) & 1) == 0;
+                }
+            }
+            nodes.push_back({static_cast<int64_t>(row_count), null_count});
+            const size_t validity_size = validity[column] != nullptr ? bitmap_size : 0;
+            buffers.push_back({body_length, static_cast<int64_t>(validity_size)});
+            body_length += AlignUp(validity_size, 8);
+            buffers.push_back({body_length, static_cast<int64_t>(values_size)});
+            body_length += AlignUp(values_size, 8);
+        }
+
+        const ChildWriter header = [&](FlatBuilder& builder) {
+            return builder.AddTable({
+                {0, 8, row_count, nullptr},
+                {1, 0, 0, [&](FlatBuilder& builder) {
+                    return builder.AddStructVector(nodes.data(), nodes.size(), sizeof(FieldNode));
+                }},
+                {2, 0, 0, [&](FlatBuilder& builder) {
+                    return builder.AddStructVector(buffers.data(), buffers.size(), sizeof(Buffer));
+                }},
+            });
+        };
+        Block block;
+        WriteMessage(MessageMetadata(kHeaderRecordBatch, header, body_length), body_length, &block);
+        // Тело пакета записывается прямо из переданных буферов
+        for (size_t column = 0; column < columns.size(); ++column) {
+            if (validity[column] != nullptr) {
+                Write(validity[column], bitmap_size);
+                WritePadding(AlignUp(bitmap_size, 8) - bitmap_size);
+            }
+            Write(columns[column], values_size);
+            WritePadding(AlignUp(values_size, 8) - values_size);
+        }
+        batches_.push_back(block);
+    }
+
+    void Writer::Finish() {
+        // Маркер конца потока сообщений
+        const uint32_t end_of_stream[2] = {kContinuation, 0};
+        Write(end_of_stream, sizeof(end_of_stream));
+        const std::string footer = FlatBuilder().Finish([&](FlatBuilder& builder) {
+            return builder.AddTable({
+                {0, 2, static_cast<uint64_t>(kMetadataVersionV5), nullptr},
+                {1, 0, 0, SchemaWriter(column_names_)},
+                {2, 0, 0, [](FlatBuilder& builder) { return builder.AddStructVector(nullptr, 0, kBlockSize); }},
+                {3, 0, 0, [&](FlatBuilder& builder) {
+                    std::vector<char> blocks(batches_.size() * kBlockSize, '\0');
+                    for (size_t i = 0; i < batches_.size(); ++i) {
+                        std::memcpy(&blocks[i * kBlockSize], &batches_[i].offset, sizeof(uint64_t));
+                        std::memcpy(&blocks[i * kBlockSize + 8], &batches_[i].metadata_length, sizeof(uint32_t));
+                        std::memcpy(&blocks[i * kBlockSize + 16], &batches_[i].body_length, sizeof(uint64_t));
+                    }
+                    return builder.AddStructVector(blocks.data(), batches_.size(), kBlockSize);
+                }},
+            });
+        });
+        Write(footer.data(), footer.size());
+        const int32_t footer_length = static_cast<int32_t>(footer.size());
+        Write(&footer_length, sizeof(footer_length));
+        Write(kMagic.data(), kMagic.size());
+    }
+
+    void Writer::WriteMessage(const std::string& metadata, uint64_t body_length, Block* block) {
+        // Префикс и метаданные вместе занимают число байт, кратное 8
+        const size_t padded = AlignUp(metadata.size() + 2 * sizeof(uint32_t), 8) - 2 * sizeof(uint32_t);
+        if (block != nullptr) {
+            block->offset = position_;
+            block->metadata_length = static_cast<uint32_t>(padded + 2 * sizeof(uint32_t));
+            block->body_length = body_length;
+        }
+        const uint32_t prefix[2] = {kContinuation, static_cast<uint32_t>(padded)};
+        Write(prefix, sizeof(prefix));
+        Write(metadata.data(), metadata.size());
+        WritePadding(padded - metadata.size());
+    }
+
+    void Writer::Write(const void* data, size_t size) {
+        FileIo::WriteAll(fd_, static_cast<const char*>(data), size);
+        position_ += size;
+    }
+
+    void Writer::WritePadding(size_t size) {
+        static constexpr char kZeros[8] = {};
+        Write(kZeros, size);
+    }
+
+} //End of namespace Arrow
@@ -1,52 +1,72 @@
 #include "ast.h"
 #include "token.h"
+#include "simd_kernels.h"
+#include <array>
 #include <cmath>
+#include <limits>
 #include <stdexcept>
+#include <vector>
 
 
 double VariableNode::Evaluate(const Token::Variables& vars) const {
-    auto it = vars.find(name_);
-    if (it == vars.end()) {
-        throw std::runtime_error("Unknown variable: " + name_);
+    return Operations::ResolveVariable(name_, vars);
+}
+
+namespace {
+
+    // Короткие цепочки вычисляются без выделения памяти
+    constexpr size_t kInlineChainLength = 64;
+
+} //End of anonymous namespace
+
+BinaryOpNode::~BinaryOpNode() {
+    /* Узлы цепочки, которыми больше никто не владеет, освобождаются по одному:
+       каждый теряет левый операнд до удаления, и деструкторы не вкладываются */
+    std::shared_ptr<const ASTNode> next = std::move(left_node_);
+    const BinaryOpNode* binary = left_binary_;
+    while (binary != nullptr && next.use_count() == 1) {
+        // Узлы создаются неконстантными, константен только указатель на них
+        BinaryOpNode& owned = const_cast<BinaryOpNode&>(*binary);
+        std::shared_ptr<const ASTNode> left = std::move(owned.left_node_);
+        binary = owned.left_binary_;
+        next = std::move(left);
+    }
+}
+
+double BinaryOpNode::Evaluate(const Token::Variables& vars) const {
+    if (left_binary_ == nullptr) {
+        double leftVal = left_node_->Evaluate(vars);
+        double rightVal = right_node_->Evaluate(vars);
+        return Operations::Binary(operator_type_, leftVal, rightVal);
+    }
+    /* Цепочка вычисляется снизу вверх в том же порядке, что и рекурсивный обход */
+    size_t length = 0;
+    for (const BinaryOpNode* node = this; node != nullptr; node = node->left_binary_) {
+        ++length;
     }
-    if(std::holds_alternative<double>(it->second)){
-        return std::get<double>(it->second);
+    const BinaryOpNode* inline_chain[kInlineChainLength];
+    std::vector<const BinaryOpNode*> long_chain(length > kInlineChainLength ? length : 0);
+    const BinaryOpNode** chain = length > kInlineChainLength ? long_chain.data() : inline_chain;
+    const BinaryOpNode* node = this;
+    for (size_t i = length; i-- > 0; node = node->left_binary_) {
+        chain[i] = node;
     }
-    std::string var_val = std::get<std::string>(it->second);
-    if(Token::GetDefaultConstants().count(var_val)) {
-        return Token::GetDefaultConstants()[var_val];
+    double value = chain[0]->left_node_->Evaluate(vars);
+    for (size_t i = 0; i < length; ++i) {
+        value = Operations::Binary(chain[i]->operator_type_, value, chain[i]->right_node_->Evaluate(vars));
     }
-    throw std::runtime_error("Unknown variable value: " + var_val);
+    return value;
 }
 
-double BinaryOpNode::Evaluate(const Token::Variables& vars) const {
-    double leftVal = left_node_->Evaluate(vars);
-    double rightVal = right_node_->Evaluate(vars);
-    double result{0.0};
-    switch(operator_type_) {
-        case Token::TokenType::PLUS:
-            result = std::isfinite(leftVal + rightVal) ? leftVal + rightVal :
-                    throw std::runtime_error("Infinite result or Nan");
-                    break; 
-        case Token::TokenType::MINUS: 
-            result = std::isfinite(leftVal - rightVal) ? leftVal - rightVal :
-                    throw std::runtime_error("Infinite result or Nan");
-                    break; 
-        case Token::TokenType::MULTIPLY: 
-            result = std::isfinite(leftVal * rightVal) ? leftVal * rightVal :
-                    throw std::runtime_error("Infinite result or Nan");
-                    break; 
-        case Token::TokenType::DIVIDE: 
-            result = std::isfinite(leftVal / rightVal) ? leftVal / rightVal :
-                    throw std::runtime_error("Infinite result or Nan");
-                    break; 
-        case Token::TokenType::POWER: 
-            result = std::isfinite(pow(leftVal, rightVal)) ? pow(leftVal, rightVal) :
-                    throw std::runtime_error("Infinite result or Nan");
-                    break;
-        default: throw std::runtime_error("Unknown binary operator");
-    }
-    return result;
+double UnaryOpNode::Evaluate(const Token::Variables& vars) const {
+    return Operations::Unary(un_operator_type_, operand_->Evaluate(vars));
+}
+
+double FunctionNode::Evaluate(const Token::Variables& vars) const {
+    if (args_ == nullptr) {
+        throw std::runtime_error("Function " + std::string(name_) + " expects exactly 1 argument");
+    }
+    return function_(args_->Evaluate(vars));
 }
 
 constexpr unsigned int MaxFactorialForDouble() {
@@ -63,46 +83,192 @@ constexpr unsigned int MaxFactorialForDouble() {
     }
 }
 
-double UnaryOpNode::Evaluate(const Token::Variables& vars) const {
-    double val = operand_->Evaluate(vars);
-    switch(un_operator_type_) {
-        case Token::TokenType::UNARY_PLUS: return +val;
-        case Token::TokenType::UNARY_MINUS: return -val;
-        case Token::TokenType::UNARY_FACTORIAL: {
-            // Проверяем, что значение целое и неотрицательное
-            if (val < 0 || val != floor(val)) {
-                throw std::runtime_error("Factorial is only defined for non-negative integers");
+namespace {
+
+    /* Все представимые в double факториалы (0! ... 170!) вычисляются при компиляции */
+    constexpr size_t kFactorialCount = MaxFactorialForDouble() + 1;
+
+    // Произведение накапливается в long double, чтобы округление каждого
+    // умножения не накапливалось в младших разрядах больших факториалов
+    constexpr std::array<double, kFactorialCount> MakeFactorialTable() {
+        std::array<double, kFactorialCount> table{};
+        long double product = 1.0L;
+        table[0] = 1.0;
+        for (size_t n = 1; n < kFactorialCount; ++n) {
+            product *= static_cast<long double>(n);
+            table[n] = static_cast<double>(product);
+        }
+        return table;
+    }
+
+    constexpr std::array<double, kFactorialCount> kFactorials = MakeFactorialTable();
+
+} //End of anonymous namespace
+
+namespace Operations {
+
+    double ResolveVariable(std::string_view name, const Token::Variables& vars) {
+        auto it = vars.find(name);
+        if (it == vars.end()) {
+            throw std::runtime_error("Unknown variable: " + std::string(name));
+        }
+        if(std::holds_alternative<double>(it->second)){
+            return std::get<double>(it->second);
+        }
+        const std::string& var_val = std::get<std::string>(it->second);
+        if(const Token::ConstantEntry* constant = Token::FindConstant(var_val)) {
+            return constant->value;
+        }
+        throw std::runtime_error("Unknown variable value: " + var_val);
+    }
+
+    const char* GetErrorMessage(EvalError error) {
+        switch (error) {
+            case EvalError::NONE: return "No error";
+            case EvalError::NON_FINITE_RESULT: return "Infinite result or Nan";
+            case EvalError::FACTORIAL_DOMAIN: return "Factorial is only defined for non-negative integers";
+            case EvalError::FACTORIAL_OVERFLOW: return "Factorial value too large";
+        }
+        return "Unknown error";
+    }
+
+    double TryBinary(Token::TokenType operator_type, double leftVal, double rightVal, EvalError& error) {
+        double result{0.0};
+        switch(operator_type) {
+            case Token::TokenType::PLUS: result = leftVal + rightVal; break;
+            case Token::TokenType::MINUS: result = leftVal - rightVal; break;
+            case Token::TokenType::MULTIPLY: result = leftVal * rightVal; break;
+            case Token::TokenType::DIVIDE: result = leftVal / rightVal; break;
+            case Token::TokenType::POWER: result = pow(leftVal, rightVal); break;
+            default: throw std::runtime_error("Unknown binary operator");
+        }
+        if (!std::isfinite(result)) {
+            error = EvalError::NON_FINITE_RESULT;
+            return NAN;
+        }
+        return result;
+    }
+
+    double TryUnary(Token::TokenType operator_type, double val, EvalError& error) {
+        switch(operator_type) {
+            case Token::TokenType::UNARY_PLUS: return +val;
+            case Token::TokenType::UNARY_MINUS: return -val;
+            case Token::TokenType::UNARY_FACTORIAL: {
+                // Проверяем, что значение целое и неотрицательное
+                if (val < 0 || val != floor(val)) {
+                    error = EvalError::FACTORIAL_DOMAIN;
+                    return NAN;
+                }
+                /* Проверяем можно ли вычислить факториал числа без переполнения */
+                if (val >= static_cast<double>(kFactorialCount)) {
+                    error = EvalError::FACTORIAL_OVERFLOW;
+                    return NAN;
+                }
+                return kFactorials[static_cast<size_t>(val)];
             }
-            const unsigned int max_val_for_factorial = MaxFactorialForDouble();
-            unsigned int n = static_cast<unsigned int>(val);
-            /* Проверяем можно ли вычислить факториал числа без переполнения */
-            if (n > max_val_for_factorial) {
-                throw std::runtime_error("Factorial value too large");
+            default: throw std::runtime_error("Unknown unary operator");
+        }
+    }
+
+    double Binary(Token::TokenType operator_type, double leftVal, double rightVal) {
+        EvalError error = EvalError::NONE;
+        const double result = TryBinary(operator_type, leftVal, rightVal, error);
+        if (error != EvalError::NONE) {
+            throw std::runtime_error(GetErrorMessage(error));
+        }
+        return result;
+    }
+
+    double Unary(Token::TokenType operator_type, double val) {
+        EvalError error = EvalError::NONE;
+        const double result = TryUnary(operator_type, val, error);
+        if (error != EvalError::NONE) {
+            throw std::runtime_error(GetErrorMessage(error));
+        }
+        return result;
+    }
+
+    static void PowerBlock(double* left, const double* right, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            left[i] = pow(left[i], right[i]);
+        }
+    }
+
+    /*
+        Блочные версии операторов: выбор операции выполняется один раз на блок,
+        а внутренний цикл содержит только арифметику и проверку результата.
+        Результат записывается на место левого операнда. Поиск строк с
+        ошибкой выполняется, только если блок целиком не прошёл проверку.
+    */
+    void BinaryBlock(Token::TokenType operator_type, double* left, const double* right, size_t count,
+                     EvalError* errors) {
+        bool finite = true;
+        switch(operator_type) {
+            case Token::TokenType::PLUS: finite = Simd::Add(left, right, count); break;
+            case Token::TokenType::MINUS: finite = Simd::Subtract(left, right, count); break;
+            case Token::TokenType::MULTIPLY: finite = Simd::Multiply(left, right, count); break;
+            case Token::TokenType::DIVIDE: finite = Simd::Divide(left, right, count); break;
+            case Token::TokenType::POWER:
+                PowerBlock(left, right, count);
+                finite = Simd::AllFinite(left, count);
+                break;
+            default: throw std::runtime_error("Unknown binary operator");
+        }
+        if (finite) {
+            return;
+        }
+        if (errors == nullptr) {
+            throw std::runtime_error(GetErrorMessage(EvalError::NON_FINITE_RESULT));
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (!std::isfinite(left[i]) && errors[i] == EvalError::NONE) {
+                errors[i] = EvalError::NON_FINITE_RESULT;
             }
-            unsigned long long result = 1;
-            
-            for (unsigned int i = 2; i <= n; ++i) {
-                result *= i;
+        }
+    }
+
+    void UnaryBlock(Token::TokenType operator_type, double* values, size_t count, EvalError* errors) {
+        size_t done = 0;
+        switch(operator_type) {
+            case Token::TokenType::UNARY_PLUS:
+                return;
+            case Token::TokenType::UNARY_MINUS:
+                Simd::Negate(values, count);
+                return;
+            case Token::TokenType::UNARY_FACTORIAL:
+                // Векторная выборка из таблицы останавливается на первом недопустимом
+                // аргументе, остаток блока вычисляется поэлементно ради точного кода ошибки
+                done = Simd::Gather(values, count, kFactorials.data(), kFactorials.size());
+                break;
+            default:
+                break;
+        }
+        for (size_t i = done; i < count; ++i) {
+            if (errors == nullptr) {
+                values[i] = Unary(operator_type, values[i]);
+                continue;
+            }
+            EvalError error = EvalError::NONE;
+            values[i] = TryUnary(operator_type, values[i], error);
+            if (errors[i] == EvalError::NONE) {
+                errors[i] = error;
             }
-            return static_cast<double>(result);
         }
-        default: throw std::runtime_error("Unknown unary operator");
     }
-}
 
-double FunctionNode::Evaluate(const Token::Variables& vars) const {
-    const Token::Functions funcs = Token::GetDefaultFunctions();
-    
-    auto it = funcs.find(name_);
-    if (it == funcs.end()) {
-        throw std::runtime_error("Unknown function: " + name_);
+    void BinaryBlockUnchecked(Token::TokenType operator_type, double* left, const double* right, size_t count) {
+        switch(operator_type) {
+            case Token::TokenType::PLUS: Simd::Add(left, right, count); break;
+            case Token::TokenType::MINUS: Simd::Subtract(left, right, count); break;
+            case Token::TokenType::MULTIPLY: Simd::Multiply(left, right, count); break;
+            case Token::TokenType::DIVIDE: Simd::Divide(left, right, count); break;
+            case Token::TokenType::POWER: PowerBlock(left, right, count); break;
+            default: throw std::runtime_error("Unknown binary operator");
+        }
     }
 
-    if (args_ == nullptr) {
-        throw std::runtime_error("Function " + name_ + " expects exactly 1 argument");
+    bool FactorialBlockUnchecked(double* values, size_t count) {
+        return Simd::Gather(values, count, kFactorials.data(), kFactorials.size()) == count;
     }
 
-    double arg = args_->Evaluate(vars);
-    double result = it->second(arg);
-    return it->second(arg);
-}
\ No newline at end of file
+} //End of namespace Operations
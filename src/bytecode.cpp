@@ -0,0 +1,609 @@
+#include "bytecode.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cfenv>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+namespace Bytecode {
+
+    namespace {
+
+        /*
+            Компиляция дерева в постфиксную последовательность инструкций:
+            сначала генерируется код операндов, затем сама операция.
+            Попутно отслеживается глубина стека, необходимая для вычисления.
+        */
+        class ProgramBuilder : public ASTVisitor {
+        public:
+            explicit ProgramBuilder(bool vectorized_math) : vectorized_math_(vectorized_math) {}
+
+            Program Build(const ASTNode& root) {
+                CountReferences(root);
+                EmitNode(root);
+                return std::move(program_);
+            }
+
+            void Visit(const NumberNode& node) override {
+                Emit(OpCode::PUSH_CONST, 0, node.GetValue(), 1);
+            }
+
+            void Visit(const VariableNode& node) override {
+                Emit(OpCode::LOAD_VAR, IndexOf(program_.variables, std::string(node.GetName())), 0.0, 1);
+            }
+
+            void Visit(const BinaryOpNode& node) override {
+                // Левая цепочка генерируется циклом; она обрывается на узле, уже сохранённом во временной ячейке
+                const size_t base = chain_.size();
+                chain_.push_back(&node);
+                for (const BinaryOpNode* link = node.GetLeftBinary(); link != nullptr && !temps_.count(link);
+                     link = link->GetLeftBinary()) {
+                    chain_.push_back(link);
+                }
+                EmitNode(chain_.back()->GetLeft());
+                for (size_t i = chain_.size(); i-- > base;) {
+                    const BinaryOpNode& link = *chain_[i];
+                    EmitNode(link.GetRight());
+                    Emit(ToOpCode(link.GetOperatorType()), 0, 0.0, -1);
+                    // Общий узел внутри цепочки сохраняется так же, как в EmitNode
+                    if (i != base) {
+                        StoreIfShared(link);
+                    }
+                }
+                chain_.resize(base);
+            }
+
+            void Visit(const UnaryOpNode& node) override {
+                EmitNode(node.GetOperand());
+                Emit(ToOpCode(node.GetOperatorType()), 0, 0.0, 0);
+            }
+
+            void Visit(const FunctionNode& node) override {
+                const Token::FunctionEntry function = node.GetFunction();
+                if (node.GetArgument() == nullptr) {
+                    throw std::runtime_error("Function " + std::string(node.GetName()) + " expects exactly 1 argument");
+                }
+                EmitNode(*node.GetArgument());
+                const uint32_t index = IndexOf(program_.functions, function.function);
+                if (index == program_.block_functions.size()) {
+                    // Для пакетного режима по возможности подбирается векторная реализация
+                    program_.block_functions.push_back(vectorized_math_ ? function.block_function : nullptr);
+                }
+                Emit(OpCode::CALL, index, 0.0, 0);
+            }
+
+        private:
+            /*
+                После устранения общих подвыражений дерево становится DAG.
+                Узел с несколькими родителями вычисляется один раз: его значение
+                сохраняется во временную ячейку (STORE_TEMP оставляет значение
+                на стеке), а последующие вхождения читают её через LOAD_TEMP.
+            */
+            void EmitNode(const ASTNode& node) {
+                auto temp = temps_.find(&node);
+                if (temp != temps_.end()) {
+                    Emit(OpCode::LOAD_TEMP, temp->second, 0.0, 1);
+                    return;
+                }
+                node.Accept(*this);
+                StoreIfShared(node);
+            }
+
+            void StoreIfShared(const ASTNode& node) {
+                if (IsShared(node)) {
+                    const uint32_t index = static_cast<uint32_t>(program_.temp_count++);
+                    temps_.emplace(&node, index);
+                    Emit(OpCode::STORE_TEMP, index, 0.0, 0);
+                }
+            }
+
+            // Листья дешевле перечитать, чем хранить во временной ячейке
+            bool IsShared(const ASTNode& node) const {
+                if (dynamic_cast<const NumberNode*>(&node) || dynamic_cast<const VariableNode*>(&node)) {
+                    return false;
+                }
+                auto it = references_.find(&node);
+                return it != references_.end() && it->second > 1;
+            }
+
+            // Обход с явным стеком: порядок посещения для подсчёта ссылок не важен
+            void CountReferences(const ASTNode& root) {
+                std::vector<const ASTNode*> pending{&root};
+                while (!pending.empty()) {
+                    const ASTNode& node = *pending.back();
+                    pending.pop_back();
+                    if (references_[&node]++ > 0) {
+                        continue;
+                    }
+                    if (auto binary = dynamic_cast<const BinaryOpNode*>(&node)) {
+                        pending.push_back(&binary->GetRight());
+                        pending.push_back(&binary->GetLeft());
+                    } else if (auto unary = dynamic_cast<const UnaryOpNode*>(&node)) {
+                        pending.push_back(&unary->GetOperand());
+                    } else if (auto function = dynamic_cast<const FunctionNode*>(&node)) {
+                        if (function->GetArgument() != nullptr) {
+                            pending.push_back(function->GetArgument());
+                        }
+                    }
+                }
+            }
+
+            void Emit(OpCode op, uint32_t operand, double value, std::ptrdiff_t stack_effect) {
+                program_.code.push_back({op, operand, value});
+                depth_ += stack_effect;
+                program_.max_stack_depth = std::max(program_.max_stack_depth, static_cast<size_t>(depth_));
+            }
+
+            template <typename T>
+            static uint32_t IndexOf(std::vector<T>& items, const T& item) {
+                auto it = std::find(items.begin(), items.end(), item);
+                if (it == items.end()) {
+                    items.push_back(item);
+                    return static_cast<uint32_t>(items.size() - 1);
+                }
+                return static_cast<uint32_t>(it - items.begin());
+            }
+
+            static OpCode ToOpCode(Token::TokenType type) {
+                switch (type) {
+                    case Token::TokenType::PLUS: return OpCode::ADD;
+                    case Token::TokenType::MINUS: return OpCode::SUB;
+                    case Token::TokenType::MULTIPLY: return OpCode::MUL;
+                    case Token::TokenType::DIVIDE: return OpCode::DIV;
+                    case Token::TokenType::POWER: return OpCode::POW;
+                    case Token::TokenType::UNARY_MINUS: return OpCode::NEG;
+                    case Token::TokenType::UNARY_PLUS: return OpCode::PLUS;
+                    case Token::TokenType::UNARY_FACTORIAL: return OpCode::FACTORIAL;
+                    default: throw std::runtime_error("Unknown operator");
+                }
+            }
+
+        private:
+            Program program_;
+            std::ptrdiff_t depth_ = 0;
+            bool vectorized_math_;
+            std::unordered_map<const ASTNode*, size_t> references_;
+            std::unordered_map<const ASTNode*, uint32_t> temps_;
+            std::vector<const BinaryOpNode*> chain_;
+        };
+
+        constexpr size_t kInlineStackSize = 64;
+
+        /*
+            Флаги FPU, означающие нечисловой результат при конечных операндах.
+            На x86-64 арифметика double выполняется в SSE, поэтому флаги читаются
+            и сбрасываются прямо в MXCSR: это заметно дешевле feclearexcept и
+            fetestexcept, которые затрагивают ещё и окружение x87.
+        */
+#if defined(__x86_64__) || defined(_M_X64)
+        constexpr unsigned int kFpErrors = 0x01 | 0x04 | 0x08; // IE, ZE, OE
+
+        inline void ClearFpErrors() {
+            _mm_setcsr(_mm_getcsr() & ~kFpErrors);
+        }
+
+        inline bool HasFpErrors() {
+            return (_mm_getcsr() & kFpErrors) != 0;
+        }
+#else
+        constexpr int kFpErrors = FE_OVERFLOW | FE_INVALID | FE_DIVBYZERO;
+
+        inline void ClearFpErrors() {
+            std::feclearexcept(kFpErrors);
+        }
+
+        inline bool HasFpErrors() {
+            return std::fetestexcept(kFpErrors) != 0;
+        }
+#endif
+
+        // Флаги FPU не сообщают об операциях над inf и NaN, поэтому входы проверяются отдельно
+        bool SlotsFinite(const Program& program, const double* slots) {
+            bool finite = true;
+            for (size_t slot = 0; slot < program.variables.size(); ++slot) {
+                finite &= std::isfinite(slots[slot]);
+            }
+            return finite;
+        }
+
+        bool ColumnsFinite(const Program& program, const double* const* columns, size_t row, size_t count) {
+            for (size_t slot = 0; slot < program.variables.size(); ++slot) {
+                if (!Simd::AllFinite(columns[slot] + row, count)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /*
+            Кадр скалярного вычисления: стек и временные ячейки располагаются в
+            одном буфере. Для типичных выражений это массив inline_stack из
+            kInlineStackSize элементов в автоматической памяти вызывающего,
+            иначе буфер выделяется в куче.
+        */
+        class Frame {
+        public:
+            Frame(const Program& program, double* inline_stack) : stack_(inline_stack) {
+                const size_t frame_size = program.max_stack_depth + program.temp_count;
+                if (frame_size > kInlineStackSize) {
+                    heap_stack_.resize(frame_size);
+                    stack_ = heap_stack_.data();
+                }
+                temps_ = stack_ + program.max_stack_depth;
+            }
+            Frame(const Frame&) = delete;
+            Frame& operator=(const Frame&) = delete;
+
+            double* Stack() const { return stack_; }
+            double* Temps() const { return temps_; }
+        private:
+            std::vector<double> heap_stack_;
+            double* stack_;
+            double* temps_;
+        };
+
+        Token::TokenType ToTokenType(OpCode op) {
+            switch (op) {
+                case OpCode::ADD: return Token::TokenType::PLUS;
+                case OpCode::SUB: return Token::TokenType::MINUS;
+                case OpCode::MUL: return Token::TokenType::MULTIPLY;
+                case OpCode::DIV: return Token::TokenType::DIVIDE;
+                case OpCode::POW: return Token::TokenType::POWER;
+                default: throw std::runtime_error("Unknown binary operator");
+            }
+        }
+
+    } //End of anonymous namespace
+
+    Program Compile(const ASTNode& root, bool vectorized_math) {
+        return ProgramBuilder(vectorized_math).Build(root);
+    }
+
+    std::vector<double> BindVariables(const Program& program, const Token::Variables& vars) {
+        // Каждой переменной выражения соответствует ячейка с тем же индексом
+        std::vector<double> slots;
+        slots.reserve(program.variables.size());
+        for (const std::string& name : program.variables) {
+            slots.push_back(Operations::ResolveVariable(name, vars));
+        }
+        return slots;
+    }
+
+    namespace {
+
+        // При ошибке вычисление с исключениями бросает её, а без исключений возвращает NaN
+        template <bool kThrow>
+        double Fail(Operations::EvalError error) {
+            if constexpr (kThrow) {
+                throw std::runtime_error(Operations::GetErrorMessage(error));
+            }
+            return NAN;
+        }
+
+        /*
+            Вычисление первых code_size инструкций без проверок после операций.
+            Возвращает false, если результат может быть ошибочным и вычисление
+            нужно повторить с точной проверкой.
+        */
+        bool RunDeferred(const Program& program, size_t code_size, const double* slots, double& result) {
+            double inline_stack[kInlineStackSize];
+            const Frame frame(program, inline_stack);
+            double* stack = frame.Stack();
+            double* temps = frame.Temps();
+
+            bool finite = SlotsFinite(program, slots);
+            ClearFpErrors();
+            Operations::EvalError error = Operations::EvalError::NONE;
+            size_t top = 0;
+            for (size_t pc = 0; pc < code_size; ++pc) {
+                const Instruction& instr = program.code[pc];
+                switch (instr.op) {
+                    case OpCode::PUSH_CONST:
+                        stack[top++] = instr.value;
+                        break;
+                    case OpCode::LOAD_VAR:
+                        stack[top++] = slots[instr.operand];
+                        break;
+                    case OpCode::ADD:
+                        --top;
+                        stack[top - 1] += stack[top];
+                        break;
+                    case OpCode::SUB:
+                        --top;
+                        stack[top - 1] -= stack[top];
+                        break;
+                    case OpCode::MUL:
+                        --top;
+                        stack[top - 1] *= stack[top];
+                        break;
+                    case OpCode::DIV:
+                        --top;
+                        stack[top - 1] /= stack[top];
+                        break;
+                    case OpCode::POW:
+                        --top;
+                        stack[top - 1] = pow(stack[top - 1], stack[top]);
+                        break;
+                    case OpCode::NEG:
+                        stack[top - 1] = -stack[top - 1];
+                        break;
+                    case OpCode::PLUS:
+                        break;
+                    case OpCode::FACTORIAL:
+                        stack[top - 1] = Operations::TryUnary(Token::TokenType::UNARY_FACTORIAL, stack[top - 1], error);
+                        break;
+                    case OpCode::CALL:
+                        stack[top - 1] = program.functions[instr.operand](stack[top - 1]);
+                        finite &= std::isfinite(stack[top - 1]);
+                        break;
+                    case OpCode::STORE_TEMP:
+                        temps[instr.operand] = stack[top - 1];
+                        break;
+                    case OpCode::LOAD_TEMP:
+                        stack[top++] = temps[instr.operand];
+                        break;
+                }
+            }
+            result = stack[0];
+            return finite && error == Operations::EvalError::NONE && !HasFpErrors();
+        }
+
+        // Вычисляет первые code_size инструкций программы
+        template <bool kThrow>
+        double Run(const Program& program, size_t code_size, const double* slots, Operations::EvalError& error) {
+            if (program.deferred_checks) {
+                double result;
+                if (RunDeferred(program, code_size, slots, result)) {
+                    return result;
+                }
+            }
+            double inline_stack[kInlineStackSize];
+            const Frame frame(program, inline_stack);
+            double* stack = frame.Stack();
+            double* temps = frame.Temps();
+
+            size_t top = 0;
+            for (size_t pc = 0; pc < code_size; ++pc) {
+                const Instruction& instr = program.code[pc];
+                switch (instr.op) {
+                    case OpCode::PUSH_CONST:
+                        stack[top++] = instr.value;
+                        break;
+                    case OpCode::LOAD_VAR:
+                        stack[top++] = slots[instr.operand];
+                        break;
+                    case OpCode::ADD:
+                        --top;
+                        stack[top - 1] = Operations::TryBinary(Token::TokenType::PLUS, stack[top - 1], stack[top], error);
+                        if (error != Operations::EvalError::NONE) {
+                            return Fail<kThrow>(error);
+                        }
+                        break;
+                    case OpCode::SUB:
+                        --top;
+                        stack[top - 1] = Operations::TryBinary(Token::TokenType::MINUS, stack[top - 1], stack[top], error);
+                        if (error != Operations::EvalError::NONE) {
+                            return Fail<kThrow>(error);
+                        }
+                        break;
+                    case OpCode::MUL:
+                        --top;
+                        stack[top - 1] = Operations::TryBinary(Token::TokenType::MULTIPLY, stack[top - 1], stack[top], error);
+                        if (error != Operations::EvalError::NONE) {
+                            return Fail<kThrow>(error);
+                        }
+                        break;
+                    case OpCode::DIV:
+                        --top;
+                        stack[top - 1] = Operations::TryBinary(Token::TokenType::DIVIDE, stack[top - 1], stack[top], error);
+                        if (error != Operations::EvalError::NONE) {
+                            return Fail<kThrow>(error);
+                        }
+                        break;
+                    case OpCode::POW:
+                        --top;
+                        stack[top - 1] = Operations::TryBinary(Token::TokenType::POWER, stack[top - 1], stack[top], error);
+                        if (error != Operations::EvalError::NONE) {
+                            return Fail<kThrow>(error);
+                        }
+                        break;
+                    case OpCode::NEG:
+                        stack[top - 1] = -stack[top - 1];
+                        break;
+                    case OpCode::PLUS:
+                        break;
+                    case OpCode::FACTORIAL:
+                        stack[top - 1] = Operations::TryUnary(Token::TokenType::UNARY_FACTORIAL, stack[top - 1], error);
+                        if (error != Operations::EvalError::NONE) {
+                            return Fail<kThrow>(error);
+                        }
+                        break;
+                    case OpCode::CALL:
+                        stack[top - 1] = program.functions[instr.operand](stack[top - 1]);
+                        break;
+                    case OpCode::STORE_TEMP:
+                        temps[instr.operand] = stack[top - 1];
+                        break;
+                    case OpCode::LOAD_TEMP:
+                        stack[top++] = temps[instr.operand];
+                        break;
+                }
+            }
+            return stack[0];
+        }
+
+    } //End of anonymous namespace
+
+    double Execute(const Program& program, const double* slots) {
+        Operations::EvalError error = Operations::EvalError::NONE;
+        return Run<true>(program, program.code.size(), slots, error);
+    }
+
+    double Execute(const Program& program, const double* slots, Operations::EvalError& error) {
+        error = Operations::EvalError::NONE;
+        return Run<false>(program, program.code.size(), slots, error);
+    }
+
+    /*
+        Неизвестная переменная сообщается, только когда вычисление доходит до
+        её загрузки: ошибка в предшествующей части выражения сообщается первой,
+        как при обходе дерева.
+    */
+    double Execute(const Program& program, const Token::Variables& vars) {
+        std::vector<double> slots(program.variables.size());
+        std::vector<std::string> unresolved;
+        for (size_t slot = 0; slot < program.variables.size(); ++slot) {
+            try {
+                slots[slot] = Operations::ResolveVariable(program.variables[slot], vars);
+            } catch (const std::runtime_error& e) {
+                unresolved.resize(program.variables.size());
+                unresolved[slot] = e.what();
+                slots[slot] = NAN;
+            }
+        }
+        if (unresolved.empty()) {
+            return Execute(program, slots.data());
+        }
+        const auto load = std::find_if(program.code.begin(), program.code.end(), [&](const Instruction& instr) {
+            return instr.op == OpCode::LOAD_VAR && !unresolved[instr.operand].empty();
+        });
+        // Часть программы до загрузки выполняется только ради её ошибок
+        const size_t prefix_size = static_cast<size_t>(load - program.code.begin());
+        if (prefix_size != 0) {
+            Operations::EvalError error = Operations::EvalError::NONE;
+            Run<true>(program, prefix_size, slots.data(), error);
+        }
+        throw std::runtime_error(unresolved[load->operand]);
+    }
+
+    namespace {
+
+        /*
+            Блок вычисляется с проверкой ошибок после каждой инструкции (kDeferred = false)
+            или без неё (kDeferred = true). Во втором случае возвращается false, если
+            результат блока может содержать ошибку: функция вернула нечисловое
+            значение или аргумент факториала недопустим. Переполнение и недопустимые
+            операции фиксируются флагами исключений FPU, а конечность входных
+            столбцов проверяется до вычисления блока.
+        */
+        template <bool kDeferred>
+        bool RunBlock(const Program& program, const double* const* columns, size_t row, size_t count,
+                      double* stack, double* temps, Operations::EvalError* errors) {
+            bool finite = true;
+            double* top = stack;
+            for (const Instruction& instr : program.code) {
+                switch (instr.op) {
+                    case OpCode::PUSH_CONST:
+                        std::fill(top, top + count, instr.value);
+                        top += kBatchBlockSize;
+                        break;
+                    case OpCode::LOAD_VAR:
+                        std::copy(columns[instr.operand] + row, columns[instr.operand] + row + count, top);
+                        top += kBatchBlockSize;
+                        break;
+                    case OpCode::ADD:
+                    case OpCode::SUB:
+                    case OpCode::MUL:
+                    case OpCode::DIV:
+                    case OpCode::POW:
+                        top -= kBatchBlockSize;
+                        if constexpr (kDeferred) {
+                            Operations::BinaryBlockUnchecked(ToTokenType(instr.op), top - kBatchBlockSize, top, count);
+                        } else {
+                            Operations::BinaryBlock(ToTokenType(instr.op), top - kBatchBlockSize, top, count, errors);
+                        }
+                        break;
+                    case OpCode::NEG:
+                        Operations::UnaryBlock(Token::TokenType::UNARY_MINUS, top - kBatchBlockSize, count);
+                        break;
+                    case OpCode::PLUS:
+                        break;
+                    case OpCode::FACTORIAL:
+                        if constexpr (kDeferred) {
+                            if (!Operations::FactorialBlockUnchecked(top - kBatchBlockSize, count)) {
+                                return false;
+                            }
+                        } else {
+                            Operations::UnaryBlock(Token::TokenType::UNARY_FACTORIAL, top - kBatchBlockSize, count,
+                                                   errors);
+                        }
+                        break;
+                    case OpCode::CALL: {
+                        double* values = top - kBatchBlockSize;
+                        if (program.block_functions[instr.operand] != nullptr) {
+                            program.block_functions[instr.operand](values, count);
+                        } else {
+                            double (*function)(double) = program.functions[instr.operand];
+                            for (size_t i = 0; i < count; ++i) {
+                                values[i] = function(values[i]);
+                            }
+                        }
+                        if constexpr (kDeferred) {
+                            finite &= Simd::AllFinite(values, count);
+                        }
+                        break;
+                    }
+                    case OpCode::STORE_TEMP:
+                        std::copy(top - kBatchBlockSize, top - kBatchBlockSize + count,
+                                  temps + instr.operand * kBatchBlockSize);
+                        break;
+                    case OpCode::LOAD_TEMP:
+                        std::copy(temps + instr.operand * kBatchBlockSize,
+                                  temps + instr.operand * kBatchBlockSize + count, top);
+                        top += kBatchBlockSize;
+                        break;
+                }
+            }
+            return finite;
+        }
+
+    } //End of anonymous namespace
+
+    /*
+        Пакетное вычисление: строки обрабатываются блоками по kBatchBlockSize,
+        каждая инструкция применяется сразу ко всему блоку. Элемент стека
+        виртуальной машины - это блок значений, а не одно число.
+        При отложенной проверке блок сначала вычисляется без проверок, и только
+        если флаги FPU сообщают об ошибке, он вычисляется повторно с точной
+        проверкой, которая находит строку и инструкцию с ошибкой.
+    */
+    void ExecuteBatch(const Program& program, const double* const* columns, double* out, size_t row_count,
+                      Operations::EvalError* errors) {
+        if (errors != nullptr) {
+            std::fill(errors, errors + row_count, Operations::EvalError::NONE);
+        }
+        std::vector<double> stack((std::max<size_t>(program.max_stack_depth, 1) + program.temp_count) * kBatchBlockSize);
+        double* temps = stack.data() + std::max<size_t>(program.max_stack_depth, 1) * kBatchBlockSize;
+
+        for (size_t row = 0; row < row_count; row += kBatchBlockSize) {
+            const size_t count = std::min(kBatchBlockSize, row_count - row);
+            Operations::EvalError* block_errors = errors != nullptr ? errors + row : nullptr;
+            if (program.deferred_checks) {
+                ClearFpErrors();
+                if (ColumnsFinite(program, columns, row, count) &&
+                    RunBlock<true>(program, columns, row, count, stack.data(), temps, nullptr) &&
+                    !HasFpErrors()) {
+                    std::copy(stack.data(), stack.data() + count, out + row);
+                    continue;
+                }
+            }
+            RunBlock<false>(program, columns, row, count, stack.data(), temps, block_errors);
+            std::copy(stack.data(), stack.data() + count, out + row);
+            if (block_errors != nullptr) {
+                for (size_t i = 0; i < count; ++i) {
+                    if (block_errors[i] != Operations::EvalError::NONE) {
+                        out[row + i] = NAN;
+                    }
+                }
+            }
+        }
+    }
+
+} //End of namespace Bytecode
@@ -1,19 +1,65 @@
 #include "calculator.h"
 #include "lexer.h"
 #include "parser.h"
+#include "optimizer.h"
 #include "token.h"
+#include <algorithm>
+#include <memory_resource>
 #include <string>
 
+namespace {
 
-double Calculator::Calculate(const std::string& expression, 
-    const std::map<std::string, std::variant<double, std::string>>& vars) {
+    // Временная арена токенов и промежуточных деревьев: размер на символ выражения
+    constexpr size_t kScratchBytesPerChar = 256;
+    // Арена итогового дерева: размер на токен, каждый токен даёт не больше одного узла
+    constexpr size_t kRetainedBytesPerToken = 96;
+    constexpr size_t kMinArenaBytes = 256;
+    // Для очень длинных выражений арены растут по мере надобности
+    constexpr size_t kMaxInitialArenaBytes = 64 << 20;
+
+    size_t InitialArenaSize(size_t bytes) {
+        return std::clamp(bytes, kMinArenaBytes, kMaxInitialArenaBytes);
+    }
+
+} //End of anonymous namespace
+
+double Calculator::Calculate(std::string_view expression, const Token::Variables& vars) {
     
+    /* Вычисление значения однократно скомпилированного выражения. Свёртка
+       констант не выполняется: при однократном вычислении она ничего не
+       экономит, а её ошибки опередили бы ошибки вычисления левее по выражению */
+    CompileOptions options;
+    options.fold_constants = false;
+    return Compile(expression, options).Evaluate(vars);
+}
+
+CompiledExpression Calculator::Compile(std::string_view expression, const CompileOptions& options) const {
+    /* Токены и промежуточные деревья размещаются во временной арене, которая
+       освобождается по завершении компиляции. Скомпилированное выражение
+       хранит только арену итогового дерева: в неё пишет последний этап */
+    std::pmr::monotonic_buffer_resource scratch(InitialArenaSize(expression.size() * kScratchBytesPerChar));
     /* Разбивка входной строки выражения на токены */
-    Lexer lexer(expression);
+    Lexer lexer(expression, functions_, &scratch);
     auto tokens = lexer.GetTokens();
+    auto arena = std::make_shared<std::pmr::monotonic_buffer_resource>(
+        InitialArenaSize(tokens.size() * kRetainedBytesPerToken));
+    const bool optimize = options.fold_constants || options.eliminate_common_subexpressions;
     /* Формирование абстрактного синтаксического дерева */
-    Parser parser(tokens);
-    auto ast = parser.Parse();
-    /* Вычисление значения */
-    return ast->Evaluate(vars);
+    Parser parser(tokens, expression, functions_, optimize ? &scratch : arena.get());
+    std::shared_ptr<const ASTNode> ast = parser.Parse();
+    /* Предварительное вычисление константных подвыражений */
+    if (options.fold_constants) {
+        ast = Optimizer::FoldConstants(*ast, options.eliminate_common_subexpressions ? &scratch : arena.get());
+    }
+    /* Объединение одинаковых поддеревьев в общие узлы */
+    Optimizer::CseStats cse_stats;
+    if (options.eliminate_common_subexpressions) {
+        ast = Optimizer::EliminateCommonSubexpressions(*ast, &cse_stats, arena.get());
+    }
+    return CompiledExpression(std::move(arena), std::move(ast), options, cse_stats);
+}
+
+void Calculator::RegisterFunction(const std::string& name, double (*function)(double),
+                                  void (*block_function)(double*, size_t)) {
+    functions_.Register(name, function, block_function);
 }
@@ -0,0 +1,290 @@
+#include "calculator_server.h"
+#include <cerrno>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+namespace {
+
+    // Пока ответы не отправлены, запросы соединения не читаются
+    constexpr size_t kMaxPendingOutput = 16 << 20;
+    constexpr size_t kReadChunkSize = 64 << 10;
+    constexpr size_t kFrameHeaderSize = sizeof(uint32_t);
+
+    [[noreturn]] void ThrowSystemError(const std::string& what) {
+        throw std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    uint32_t LoadLittleEndian32(const char* data) {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+        return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 |
+               static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+    }
+
+    void AppendLittleEndian(std::string& out, uint64_t value, size_t size) {
+        for (size_t byte = 0; byte < size; ++byte) {
+            out.push_back(static_cast<char>(value >> (8 * byte) & 0xFF));
+        }
+    }
+
+    void AppendResponse(std::string& out, uint8_t status, std::string_view payload) {
+        AppendLittleEndian(out, payload.size() + 1, kFrameHeaderSize);
+        out.push_back(static_cast<char>(status));
+        out.append(payload.data(), payload.size());
+    }
+
+} //End of anonymous namespace
+
+CalculatorServer::CalculatorServer(ExpressionCache& cache, std::string socket_path)
+    : evaluator_(cache), socket_path_(std::move(socket_path)) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path_.empty() || socket_path_.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Invalid socket path: " + socket_path_);
+    }
+    std::memcpy(address.sun_path, socket_path_.data(), socket_path_.size());
+    // Сокет, оставшийся от прошлого запуска, заменяется; другие файлы не трогаются
+    struct stat info;
+    if (lstat(socket_path_.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(socket_path_.c_str());
+    }
+
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        ThrowSystemError("Cannot create socket");
+    }
+    bound_ = bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    if (bound_) {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    if (!bound_ || listen(listen_fd_, SOMAXCONN) != 0 || epoll_fd_ < 0 || stop_fd_ < 0) {
+        const int error = errno;
+        Shutdown();
+        errno = error;
+        ThrowSystemError("Cannot listen on " + socket_path_);
+    }
+    for (int fd : {listen_fd_, stop_fd_}) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+CalculatorServer::~CalculatorServer() {
+    Shutdown();
+}
+
+void CalculatorServer::Shutdown() {
+    for (auto& [fd, connection] : connections_) {
+        close(fd);
+    }
+    connections_.clear();
+    for (int* fd : {&listen_fd_, &epoll_fd_, &stop_fd_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    if (bound_) {
+        unlink(socket_path_.c_str());
+        bound_ = false;
+    }
+}
+
+void CalculatorServer::Run() {
+    epoll_event events[64];
+    while (true) {
+        const int count = epoll_wait(epoll_fd_, events, 64, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ThrowSystemError("epoll_wait failed");
+        }
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == stop_fd_) {
+                uint64_t value;
+                [[maybe_unused]] const ssize_t ignored = read(stop_fd_, &value, sizeof(value));
+                return;
+            }
+            if (fd == listen_fd_) {
+                Accept();
+                continue;
+            }
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            Connection& connection = it->second;
+            bool keep = true;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                keep = Receive(fd, connection);
+            }
+            if (keep) {
+                keep = Send(fd, connection);
+            }
+            // Клиент закончил передачу, и все ответы отправлены
+            if (keep && connection.eof && connection.output.empty()) {
+                keep = false;
+            }
+            if (keep) {
+                UpdateEvents(fd, connection);
+            } else {
+                Close(fd);
+            }
+        }
+    }
+}
+
+void CalculatorServer::Stop() {
+    const uint64_t value = 1;
+    [[maybe_unused]] const ssize_t ignored = write(stop_fd_, &value, sizeof(value));
+}
+
+void CalculatorServer::Accept() {
+    while (true) {
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            // EAGAIN - очередь подключений пуста; остальные ошибки не останавливают сервер
+            return;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        connections_[fd].events = EPOLLIN;
+    }
+}
+
+bool CalculatorServer::Receive(int fd, Connection& connection) {
+    while (!connection.eof && connection.output.size() < kMaxPendingOutput) {
+        const size_t size = connection.input.size();
+        connection.input.resize(size + kReadChunkSize);
+        const ssize_t count = read(fd, &connection.input[size], kReadChunkSize);
+        connection.input.resize(size + static_cast<size_t>(std::max<ssize_t>(count, 0)));
+        if (count == 0) {
+            connection.eof = true;
+        } else if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
+        }
+        if (!HandleRequests(connection)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CalculatorServer::HandleRequests(Connection& connection) {
+    const std::string& input = connection.input;
+    size_t position = 0;
+    while (input.size() - position >= kFrameHeaderSize) {
+        const uint32_t length = LoadLittleEndian32(input.data() + position);
+        if (length > kMaxRequestSize) {
+            // Ответы на уже принятые запросы отправляются до закрытия соединения
+            connection.eof = true;
+            connection.input.clear();
+            return true;
+        }
+        if (input.size() - position - kFrameHeaderSize < length) {
+            break;
+        }
+        const std::string_view request(input.data() + position + kFrameHeaderSize, length);
+        position += kFrameHeaderSize + length;
+        try {
+            const double result = evaluator_.EvaluateLine(request);
+            uint64_t bits;
+            std::memcpy(&bits, &result, sizeof(bits));
+            std::string payload;
+            AppendLittleEndian(payload, bits, sizeof(bits));
+            AppendResponse(connection.output, kStatusOk, payload);
+        } catch (const std::exception& e) {
+            AppendResponse(connection.output, kStatusError, e.what());
+        }
+    }
+    connection.input.erase(0, position);
+    return true;
+}
+
+bool CalculatorServer::Send(int fd, Connection& connection) {
+    while (connection.output_sent < connection.output.size()) {
+        const ssize_t count = send(fd, connection.output.data() + connection.output_sent,
+                                   connection.output.size() - connection.output_sent, MSG_NOSIGNAL);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            return false;
+        }
+        connection.output_sent += static_cast<size_t>(count);
+    }
+    connection.output.clear();
+    connection.output_sent = 0;
+    return true;
+}
+
+void CalculatorServer::UpdateEvents(int fd, Connection& connection) {
+    uint32_t events = 0;
+    if (!connection.eof && connection.output.size() < kMaxPendingOutput) {
+        events |= EPOLLIN;
+    }
+    if (!connection.output.empty()) {
+        events |= EPOLLOUT;
+    }
+    if (events != connection.events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+        connection.events = events;
+    }
+}
+
+void CalculatorServer::Close(int fd) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(fd);
+}
+
+#else
+
+CalculatorServer::CalculatorServer(ExpressionCache& cache, std::string socket_path)
+    : evaluator_(cache), socket_path_(std::move(socket_path)) {
+    throw std::runtime_error("Server mode is only supported on Linux");
+}
+
+CalculatorServer::~CalculatorServer() = default;
+void CalculatorServer::Shutdown() {}
+void CalculatorServer::Run() {}
+void CalculatorServer::Stop() {}
+
+#endif
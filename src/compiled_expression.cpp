@@ -0,0 +1,201 @@
+#include "compiled_expression.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+    std::shared_ptr<const Bytecode::Program> CompileProgram(const ASTNode& root, const CompileOptions& options) {
+        Bytecode::Program program = Bytecode::Compile(root, !options.strict_math);
+        program.deferred_checks = options.deferred_fp_checks;
+        return std::make_shared<const Bytecode::Program>(std::move(program));
+    }
+
+} //End of anonymous namespace
+
+CompiledExpression::CompiledExpression(std::shared_ptr<std::pmr::memory_resource> arena,
+                                       std::shared_ptr<const ASTNode> root, const CompileOptions& options,
+                                       const Optimizer::CseStats& cse_stats)
+    : arena_(std::move(arena)),
+      root_(std::move(root)),
+      program_(CompileProgram(*root_, options)),
+      engine_(options.engine),
+      cse_stats_(cse_stats) {
+    if (engine_ == Engine::JIT) {
+        jit_ = Jit::CompiledFunction::Compile(*program_);
+        if (jit_ == nullptr) {
+            engine_ = Engine::BYTECODE;
+        }
+    }
+}
+
+double CompiledExpression::Evaluate(const Token::Variables& vars) const {
+    /* Синтаксическое дерево и байт-код неизменяемы, поэтому их можно вычислять повторно */
+    if (engine_ == Engine::BYTECODE) {
+        return Bytecode::Execute(*program_, vars);
+    }
+    if (engine_ == Engine::JIT) {
+        std::vector<double> slots;
+        try {
+            slots = BindVariables(vars);
+        } catch (const std::runtime_error&) {
+            // Интерпретатор сообщает ошибки в порядке вычисления
+            return Bytecode::Execute(*program_, vars);
+        }
+        return Evaluate(slots.data(), slots.size());
+    }
+    return root_->Evaluate(vars);
+}
+
+void CompiledExpression::CheckSlotCount(size_t slot_count) const {
+    if (slot_count < program_->variables.size()) {
+        throw std::runtime_error("Expected " + std::to_string(program_->variables.size()) +
+                                 " variable values, got " + std::to_string(slot_count));
+    }
+}
+
+void CompiledExpression::CheckColumnCount(size_t column_count) const {
+    if (column_count < program_->variables.size()) {
+        throw std::runtime_error("Expected " + std::to_string(program_->variables.size()) +
+                                 " variable columns, got " + std::to_string(column_count));
+    }
+}
+
+double CompiledExpression::Evaluate(const double* slots, size_t slot_count) const {
+    CheckSlotCount(slot_count);
+    if (engine_ == Engine::BYTECODE) {
+        return Bytecode::Execute(*program_, slots);
+    }
+    if (engine_ == Engine::JIT) {
+        // NaN означает ошибку или NaN в данных: точный результат или исключение даёт интерпретатор
+        const double result = jit_->Evaluate(slots);
+        return std::isnan(result) ? Bytecode::Execute(*program_, slots) : result;
+    }
+    // Эталонный обход дерева работает с именованными переменными
+    Token::Variables vars;
+    for (size_t slot = 0; slot < program_->variables.size(); ++slot) {
+        vars[program_->variables[slot]] = slots[slot];
+    }
+    return root_->Evaluate(vars);
+}
+
+double CompiledExpression::TryEvaluate(const double* slots, size_t slot_count, Operations::EvalError& error) const {
+    CheckSlotCount(slot_count);
+    if (engine_ == Engine::JIT) {
+        const double result = jit_->Evaluate(slots);
+        if (!std::isnan(result)) {
+            error = Operations::EvalError::NONE;
+            return result;
+        }
+    }
+    return Bytecode::Execute(*program_, slots, error);
+}
+
+void CompiledExpression::EvaluateBatch(const std::vector<const double*>& columns, double* out,
+                                       size_t row_count) const {
+    CheckColumnCount(columns.size());
+    RunBatch(columns, out, nullptr, row_count);
+}
+
+void CompiledExpression::EvaluateBatch(const std::vector<const double*>& columns, double* out,
+                                       size_t row_count, ThreadPool& pool) const {
+    CheckColumnCount(columns.size());
+    RunBatch(columns, out, nullptr, row_count, pool);
+}
+
+void CompiledExpression::TryEvaluateBatch(const std::vector<const double*>& columns, double* out,
+                                          Operations::EvalError* errors, size_t row_count) const {
+    CheckColumnCount(columns.size());
+    RunBatch(columns, out, errors, row_count);
+}
+
+void CompiledExpression::TryEvaluateBatch(const std::vector<const double*>& columns, double* out,
+                                          Operations::EvalError* errors, size_t row_count, ThreadPool& pool) const {
+    CheckColumnCount(columns.size());
+    RunBatch(columns, out, errors, row_count, pool);
+}
+
+void CompiledExpression::RunBatch(const std::vector<const double*>& columns, double* out,
+                                  Operations::EvalError* errors, size_t row_count) const {
+    if (engine_ == Engine::JIT && jit_->HasBatch()) {
+        EvaluateBatchJit(columns, out, errors, row_count);
+        return;
+    }
+    if (engine_ != Engine::TREE_WALKER || errors != nullptr) {
+        Bytecode::ExecuteBatch(*program_, columns.data(), out, row_count, errors);
+        return;
+    }
+    // Эталонный обход дерева вычисляет строки по одной
+    std::vector<double> slots(columns.size());
+    for (size_t row = 0; row < row_count; ++row) {
+        for (size_t slot = 0; slot < columns.size(); ++slot) {
+            slots[slot] = columns[slot][row];
+        }
+        out[row] = Evaluate(slots.data(), slots.size());
+    }
+}
+
+/*
+    Машинный код обрабатывает строки парами и останавливается на первой паре
+    с ошибкой. Такая пара, как и последняя нечётная строка, вычисляется
+    блочным интерпретатором, после чего пакетное вычисление продолжается.
+*/
+void CompiledExpression::EvaluateBatchJit(const std::vector<const double*>& columns, double* out,
+                                          Operations::EvalError* errors, size_t row_count) const {
+    std::vector<const double*> row_columns(columns.size());
+    size_t row = 0;
+    while (row < row_count) {
+        const size_t end = jit_->EvaluateBatch(columns.data(), out, row, row_count);
+        if (errors != nullptr) {
+            std::fill(errors + row, errors + end, Operations::EvalError::NONE);
+        }
+        row = end;
+        if (row == row_count) {
+            break;
+        }
+        const size_t count = std::min<size_t>(2, row_count - row);
+        for (size_t slot = 0; slot < columns.size(); ++slot) {
+            row_columns[slot] = columns[slot] + row;
+        }
+        Bytecode::ExecuteBatch(*program_, row_columns.data(), out + row, count,
+                               errors != nullptr ? errors + row : nullptr);
+        row += count;
+    }
+}
+
+/*
+    Строки делятся на фрагменты по kParallelChunkRows, которые выполняются
+    пулом потоков. Каждый фрагмент пишет в свой диапазон выходного столбца,
+    поэтому результат совпадает с последовательным вычислением.
+*/
+void CompiledExpression::RunBatch(const std::vector<const double*>& columns, double* out,
+                                  Operations::EvalError* errors, size_t row_count, ThreadPool& pool) const {
+    const size_t chunk_count = (row_count + kParallelChunkRows - 1) / kParallelChunkRows;
+    pool.ParallelFor(chunk_count, [&](size_t chunk) {
+        const size_t begin = chunk * kParallelChunkRows;
+        const size_t count = std::min(kParallelChunkRows, row_count - begin);
+        std::vector<const double*> chunk_columns(columns.size());
+        for (size_t slot = 0; slot < columns.size(); ++slot) {
+            chunk_columns[slot] = columns[slot] + begin;
+        }
+        RunBatch(chunk_columns, out + begin, errors != nullptr ? errors + begin : nullptr, count);
+    });
+}
+
+const std::vector<std::string>& CompiledExpression::GetVariableNames() const {
+    return program_->variables;
+}
+
+size_t CompiledExpression::GetVariableSlot(const std::string& name) const {
+    const auto& names = program_->variables;
+    auto it = std::find(names.begin(), names.end(), name);
+    if (it == names.end()) {
+        throw std::runtime_error("Unknown variable: " + name);
+    }
+    return static_cast<size_t>(it - names.begin());
+}
+
+std::vector<double> CompiledExpression::BindVariables(const Token::Variables& vars) const {
+    return Bytecode::BindVariables(*program_, vars);
+}
@@ -0,0 +1,171 @@
+#include "csv_evaluator.h"
+#include "variable_parser.h"
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+    constexpr std::string_view kWhitespace = " \t";
+
+    std::string_view Trim(std::string_view text) {
+        const size_t begin = text.find_first_not_of(kWhitespace);
+        if (begin == std::string_view::npos) {
+            return {};
+        }
+        return text.substr(begin, text.find_last_not_of(kWhitespace) - begin + 1);
+    }
+
+    // Поля строки без кавычек; удвоенные кавычки внутри поля не разворачиваются
+    void SplitFields(std::string_view line, std::vector<std::string_view>& fields) {
+        fields.clear();
+        size_t pos = 0;
+        while (true) {
+            const size_t begin = line.find_first_not_of(kWhitespace, pos);
+            if (begin != std::string_view::npos && line[begin] == '"') {
+                size_t end = begin + 1;
+                while (true) {
+                    end = line.find('"', end);
+                    if (end == std::string_view::npos) {
+                        throw std::runtime_error("Unterminated quoted field");
+                    }
+                    if (end + 1 < line.size() && line[end + 1] == '"') {
+                        end += 2;
+                        continue;
+                    }
+                    break;
+                }
+                fields.push_back(line.substr(begin + 1, end - begin - 1));
+                pos = line.find(',', end);
+            } else {
+                const size_t end = line.find(',', pos);
+                fields.push_back(Trim(line.substr(pos, end - pos)));
+                pos = end;
+            }
+            if (pos == std::string_view::npos) {
+                break;
+            }
+            ++pos;
+        }
+    }
+
+} //End of anonymous namespace
+
+CsvEvaluator::CsvEvaluator(const CompiledExpression& compiled, Token::Variables defaults,
+                           std::string result_column)
+    : compiled_(compiled), defaults_(std::move(defaults)), result_column_(std::move(result_column)),
+      columns_(compiled.GetVariableNames().size()) {}
+
+void CsvEvaluator::Run(FileIo::LineReader& reader, OutputWriter& writer) {
+    for (std::string_view block = reader.NextBlock(); !block.empty(); block = reader.NextBlock()) {
+        FileIo::ForEachLine(block, [&](std::string_view line) {
+            ++line_number_;
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (Trim(line).empty()) {
+                return;
+            }
+            if (!header_done_) {
+                ProcessHeader(line);
+                writer.WriteText(line);
+                writer.WriteText(",");
+                writer.WriteText(result_column_);
+                writer.WriteText("\n");
+                return;
+            }
+            ProcessRow(line);
+        });
+        EvaluateRows(writer);
+        writer.Flush();
+    }
+    if (!header_done_) {
+        throw std::runtime_error("CSV input has no header");
+    }
+}
+
+void CsvEvaluator::ProcessHeader(std::string_view line) {
+    SplitFields(line, fields_);
+    const std::vector<std::string>& names = compiled_.GetVariableNames();
+    field_of_slot_.assign(names.size(), kNoColumn);
+    default_of_slot_.assign(names.size(), 0.0);
+    for (size_t slot = 0; slot < names.size(); ++slot) {
+        for (size_t field = 0; field < fields_.size(); ++field) {
+            if (fields_[field] == names[slot]) {
+                field_of_slot_[slot] = field;
+                break;
+            }
+        }
+        if (field_of_slot_[slot] == kNoColumn) {
+            if (defaults_.find(names[slot]) == defaults_.end()) {
+                throw std::runtime_error("No CSV column or --var value for variable: " + names[slot]);
+            }
+            default_of_slot_[slot] = Operations::ResolveVariable(names[slot], defaults_);
+        }
+    }
+    header_done_ = true;
+}
+
+void CsvEvaluator::ProcessRow(std::string_view line) {
+    const std::vector<std::string>& names = compiled_.GetVariableNames();
+    // Переменная, значение которой разбирается; names.size() - разбор строки целиком
+    size_t current_slot = names.size();
+    try {
+        SplitFields(line, fields_);
+        for (size_t slot = 0; slot < names.size(); ++slot) {
+            const size_t field = field_of_slot_[slot];
+            if (field == kNoColumn) {
+                continue;
+            }
+            current_slot = slot;
+            if (field >= fields_.size()) {
+                throw std::runtime_error("Missing value");
+            }
+            const std::string_view text = fields_[field];
+            columns_[slot].push_back(VariableParser::ResolveValue(VariableParser::ParseValue(text, text)));
+        }
+    } catch (const std::exception& e) {
+        std::string context = "Line " + std::to_string(line_number_);
+        if (current_slot < names.size()) {
+            context += ", column " + names[current_slot];
+        }
+        throw std::runtime_error(context + ": " + e.what());
+    }
+    rows_.push_back(line);
+}
+
+void CsvEvaluator::EvaluateRows(OutputWriter& writer) {
+    const size_t row_count = rows_.size();
+    if (row_count == 0) {
+        return;
+    }
+    std::vector<const double*> columns(columns_.size());
+    for (size_t slot = 0; slot < columns_.size(); ++slot) {
+        if (field_of_slot_[slot] == kNoColumn) {
+            columns_[slot].assign(row_count, default_of_slot_[slot]);
+        }
+        columns[slot] = columns_[slot].data();
+    }
+    results_.resize(row_count);
+    errors_.resize(row_count);
+    compiled_.TryEvaluateBatch(columns, results_.data(), errors_.data(), row_count);
+    for (size_t row = 0; row < row_count; ++row) {
+        if (writer.IsBinary()) {
+            // Строка с ошибкой уже содержит NaN
+            writer.WriteNumber(results_[row]);
+            continue;
+        }
+        writer.WriteText(rows_[row]);
+        writer.WriteText(",");
+        if (errors_[row] == Operations::EvalError::NONE) {
+            writer.WriteNumber(results_[row]);
+        } else {
+            writer.WriteText("Error: ");
+            writer.WriteText(Operations::GetErrorMessage(errors_[row]));
+        }
+        writer.WriteText("\n");
+    }
+    rows_.clear();
+    for (std::vector<double>& column : columns_) {
+        column.clear();
+    }
+}
@@ -0,0 +1,25 @@
+#include "expression_cache.h"
+#include <algorithm>
+
+ExpressionCache::ExpressionCache(const Calculator& calc, const CompileOptions& options, size_t capacity)
+    : calc_(calc), options_(options), capacity_(std::max<size_t>(capacity, 1)) {
+    index_.reserve(capacity_);
+}
+
+const CompiledExpression& ExpressionCache::Get(std::string_view expression) {
+    auto it = index_.find(expression);
+    if (it != index_.end()) {
+        ++hits_;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->compiled;
+    }
+    ++misses_;
+    CompiledExpression compiled = calc_.Compile(expression, options_);
+    if (entries_.size() == capacity_) {
+        index_.erase(entries_.back().expression);
+        entries_.pop_back();
+    }
+    entries_.push_front(Entry{std::string(expression), std::move(compiled)});
+    index_.emplace(entries_.front().expression, entries_.begin());
+    return entries_.front().compiled;
+}
@@ -0,0 +1,233 @@
+#include "file_io.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CALCULATOR_HAS_MMAP
+#include <sys/mman.h>
+#endif
+
+namespace FileIo {
+
+    namespace {
+
+        File Open(const std::string& path, int flags) {
+            const int fd = open(path.c_str(), flags, 0644);
+            if (fd < 0) {
+                throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+            }
+            return File(fd);
+        }
+
+    } //End of anonymous namespace
+
+    File File::OpenForReading(const std::string& path) {
+        return Open(path, O_RDONLY);
+    }
+
+    File File::OpenForWriting(const std::string& path) {
+        return Open(path, O_WRONLY | O_CREAT | O_TRUNC);
+    }
+
+    File::File(File&& other) noexcept : fd_(other.fd_) {
+        other.fd_ = -1;
+    }
+
+    File& File::operator=(File&& other) noexcept {
+        if (this != &other) {
+            if (fd_ >= 0) {
+                close(fd_);
+            }
+            fd_ = other.fd_;
+            other.fd_ = -1;
+        }
+        return *this;
+    }
+
+    File::~File() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    MappedFile::MappedFile(const std::string& path) : MappedFile(File::OpenForReading(path).Get()) {}
+
+    MappedFile::MappedFile(int fd) {
+        const off_t offset = lseek(fd, 0, SEEK_CUR);
+        struct stat info;
+        if (offset < 0 || fstat(fd, &info) != 0) {
+            throw std::runtime_error(std::string("Cannot map file: ") + std::strerror(errno));
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        offset_ = std::min(static_cast<size_t>(offset), size_);
+        if (size_ == 0) {
+            return;
+        }
+#ifdef CALCULATOR_HAS_MMAP
+        void* address = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            throw std::runtime_error(std::string("Cannot map file: ") + std::strerror(errno));
+        }
+        // Подсказка необязательна, поэтому её ошибка не проверяется
+        madvise(address, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(address);
+#else
+        buffer_.resize(size_ - offset_);
+        size_t filled = 0;
+        while (filled < buffer_.size()) {
+            const size_t count = ReadSome(fd, buffer_.data() + filled, buffer_.size() - filled);
+            if (count == 0) {
+                break;
+            }
+            filled += count;
+        }
+        buffer_.resize(filled);
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        offset_ = 0;
+#endif
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : data_(other.data_), size_(other.size_), offset_(other.offset_), buffer_(std::move(other.buffer_)) {
+        if (!buffer_.empty()) {
+            data_ = buffer_.data();
+        }
+        other.data_ = nullptr;
+        other.size_ = other.offset_ = 0;
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            Unmap();
+            data_ = other.data_;
+            size_ = other.size_;
+            offset_ = other.offset_;
+            buffer_ = std::move(other.buffer_);
+            if (!buffer_.empty()) {
+                data_ = buffer_.data();
+            }
+            other.data_ = nullptr;
+            other.size_ = other.offset_ = 0;
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        Unmap();
+    }
+
+    void MappedFile::Unmap() {
+#ifdef CALCULATOR_HAS_MMAP
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+        data_ = nullptr;
+    }
+
+    size_t ReadSome(int fd, char* data, size_t size) {
+        while (true) {
+            const ssize_t count = read(fd, data, size);
+            if (count >= 0) {
+                return static_cast<size_t>(count);
+            }
+            if (errno != EINTR) {
+                throw std::runtime_error(std::string("Read failed: ") + std::strerror(errno));
+            }
+        }
+    }
+
+    void WriteAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            const ssize_t count = write(fd, data, size);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::string("Write failed: ") + std::strerror(errno));
+            }
+            data += count;
+            size -= static_cast<size_t>(count);
+        }
+    }
+
+    LineReader LineReader::Open(int fd, size_t buffer_size) {
+#ifdef CALCULATOR_HAS_MMAP
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            return LineReader(MappedFile(fd), buffer_size);
+        }
+#endif
+        return LineReader(File(), fd, buffer_size);
+    }
+
+    LineReader LineReader::OpenFile(const std::string& path, size_t buffer_size) {
+        File file = File::OpenForReading(path);
+#ifdef CALCULATOR_HAS_MMAP
+        struct stat info;
+        if (fstat(file.Get(), &info) == 0 && S_ISREG(info.st_mode)) {
+            return LineReader(MappedFile(file.Get()), buffer_size);
+        }
+#endif
+        const int fd = file.Get();
+        return LineReader(std::move(file), fd, buffer_size);
+    }
+
+    LineReader::LineReader(File file, int fd, size_t buffer_size)
+        : file_(std::move(file)), fd_(fd), block_size_(buffer_size), buffer_(buffer_size) {}
+
+    LineReader::LineReader(MappedFile mapped, size_t buffer_size)
+        : mapped_(std::make_unique<MappedFile>(std::move(mapped))), block_size_(buffer_size) {}
+
+    std::string_view LineReader::NextMappedBlock() {
+        const std::string_view data = mapped_->GetData();
+        const size_t begin = mapped_position_;
+        size_t end = std::min(begin + block_size_, data.size());
+        if (end < data.size()) {
+            // Блок заканчивается последним переводом строки; длинная строка входит целиком
+            size_t newline = data.substr(begin, end - begin).rfind('\n');
+            newline = newline != std::string_view::npos ? begin + newline : data.find('\n', end);
+            end = newline != std::string_view::npos ? newline + 1 : data.size();
+        }
+        mapped_position_ = end;
+        return data.substr(begin, end - begin);
+    }
+
+    std::string_view LineReader::NextBlock() {
+        if (mapped_ != nullptr) {
+            return NextMappedBlock();
+        }
+        std::memmove(buffer_.data(), buffer_.data() + consumed_, filled_ - consumed_);
+        filled_ -= consumed_;
+        consumed_ = 0;
+        // Перенесённый остаток уже проверен и перевода строки не содержит
+        size_t search_from = filled_;
+        while (!eof_) {
+            if (filled_ == buffer_.size()) {
+                buffer_.resize(buffer_.size() * 2);
+            }
+            const size_t count = ReadSome(fd_, buffer_.data() + filled_, buffer_.size() - filled_);
+            if (count == 0) {
+                eof_ = true;
+                break;
+            }
+            filled_ += count;
+            const size_t newline = std::string_view(buffer_.data() + search_from, filled_ - search_from).rfind('\n');
+            if (newline != std::string_view::npos) {
+                consumed_ = search_from + newline + 1;
+                return std::string_view(buffer_.data(), consumed_);
+            }
+            search_from = filled_;
+        }
+        // Последняя строка без перевода строки
+        consumed_ = filled_;
+        return std::string_view(buffer_.data(), filled_);
+    }
+
+} //End of namespace FileIo
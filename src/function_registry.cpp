@@ -0,0 +1,48 @@
+#include "function_registry.h"
+#include <cctype>
+#include <stdexcept>
+
+namespace {
+
+    bool IsIdentifier(std::string_view name) {
+        if (name.empty() || !(isalpha(static_cast<unsigned char>(name[0])) || name[0] == '_')) {
+            return false;
+        }
+        for (char c : name) {
+            if (!(isalnum(static_cast<unsigned char>(c)) || c == '_')) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+} //End of anonymous namespace
+
+const FunctionRegistry& FunctionRegistry::Builtin() {
+    static const FunctionRegistry registry;
+    return registry;
+}
+
+void FunctionRegistry::Register(const std::string& name, double (*function)(double),
+                                void (*block_function)(double*, size_t)) {
+    if (!IsIdentifier(name)) {
+        throw std::runtime_error("Invalid function name: " + name);
+    }
+    if (function == nullptr) {
+        throw std::runtime_error("Function " + name + " has no implementation");
+    }
+    // Лексер проверяет константы раньше функций, такая функция была бы недостижима
+    if (Token::FindConstant(name) != nullptr) {
+        throw std::runtime_error("Function name conflicts with constant: " + name);
+    }
+    auto it = functions_.insert_or_assign(name, Token::FunctionEntry{}).first;
+    it->second = Token::FunctionEntry{it->first, function, block_function};
+}
+
+const Token::FunctionEntry* FunctionRegistry::Find(std::string_view name) const {
+    auto it = functions_.find(name);
+    if (it != functions_.end()) {
+        return &it->second;
+    }
+    return Token::FindFunction(name);
+}
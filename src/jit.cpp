@@ -0,0 +1,468 @@
+#include "jit.h"
+#include "ast.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define CALCULATOR_JIT_X86_64 1
+#include <sys/mman.h>
+#endif
+
+namespace Jit {
+
+#ifdef CALCULATOR_JIT_X86_64
+
+    namespace {
+
+        /*
+            Значения стека виртуальной машины размещаются в регистрах:
+            элемент стека с номером d хранится в xmm<d>. Регистры xmm14 и
+            xmm15 служат рабочими. Программы с более глубоким стеком не
+            компилируются и выполняются интерпретатором.
+        */
+        constexpr int kRegisterStackSize = 14;
+        constexpr int kScratchXmm0 = 14;
+        constexpr int kScratchXmm1 = 15;
+
+        enum Gp { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7, R12 = 12, R13 = 13, R14 = 14 };
+
+        /*
+            Кадр стека относительно rbp:
+            [rbp-8 .. rbp-32]  сохранённые rbx, r12, r13, r14;
+            [rbp-64 .. rbp-33] две 16-байтовые ячейки для аргументов вызовов;
+            далее ячейки для сохранения регистров стека на время вызовов
+            и временные ячейки общих подвыражений (STORE_TEMP/LOAD_TEMP).
+        */
+        constexpr int32_t kSavedRegistersSize = 32;
+        constexpr int32_t kArgumentOffset0 = -64;
+        constexpr int32_t kArgumentOffset1 = -48;
+
+        int32_t SpillOffset(int index) {
+            return kArgumentOffset0 - 16 * (index + 1);
+        }
+
+        int32_t TempOffset(uint32_t index) {
+            return SpillOffset(kRegisterStackSize - 1) - 16 * static_cast<int32_t>(index + 1);
+        }
+
+        constexpr uint8_t kPrefixScalar = 0xF2;
+        constexpr uint8_t kPrefixPacked = 0x66;
+
+        constexpr uint8_t kOpMovLoad = 0x10;
+        constexpr uint8_t kOpMovStore = 0x11;
+        constexpr uint8_t kOpUnpackLow = 0x14;
+        constexpr uint8_t kOpMovAligned = 0x28;
+        constexpr uint8_t kOpCompareUnordered = 0x2E;
+        constexpr uint8_t kOpMoveMask = 0x50;
+        constexpr uint8_t kOpXor = 0x57;
+        constexpr uint8_t kOpAdd = 0x58;
+        constexpr uint8_t kOpMul = 0x59;
+        constexpr uint8_t kOpSub = 0x5C;
+        constexpr uint8_t kOpDiv = 0x5E;
+
+        // Факториал вызывается из сгенерированного кода, поэтому ошибка передаётся как NaN
+        double FactorialOrNan(double value) {
+            try {
+                return Operations::Unary(Token::TokenType::UNARY_FACTORIAL, value);
+            } catch (...) {
+                return NAN;
+            }
+        }
+
+        /*
+            У сгенерированного кода нет таблиц раскрутки стека, и исключение,
+            брошенное вызванной из него функцией, завершило бы программу.
+            Функции реестра вызываются через этот переходник: ошибка становится
+            NaN, и вычисление повторяет интерпретатор, который её и сообщит.
+        */
+        double CallOrNan(double value, double (*function)(double)) {
+            try {
+                return function(value);
+            } catch (...) {
+                return NAN;
+            }
+        }
+
+        uint64_t BitsOf(double value) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        class Assembler {
+        public:
+            std::vector<uint8_t>& GetCode() { return code_; }
+            size_t Position() const { return code_.size(); }
+
+            void Byte(uint8_t value) { code_.push_back(value); }
+
+            void Bytes(std::initializer_list<uint8_t> values) {
+                code_.insert(code_.end(), values.begin(), values.end());
+            }
+
+            void Imm32(int32_t value) {
+                for (int i = 0; i < 4; ++i) Byte(static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8 * i)));
+            }
+
+            void Imm64(uint64_t value) {
+                for (int i = 0; i < 8; ++i) Byte(static_cast<uint8_t>(value >> (8 * i)));
+            }
+
+            void Rex(bool w, bool r, bool x, bool b) {
+                uint8_t rex = static_cast<uint8_t>(0x40 | (w << 3) | (r << 2) | (x << 1) | b);
+                if (rex != 0x40) Byte(rex);
+            }
+
+            // op xmm, xmm
+            void SseRegister(uint8_t prefix, uint8_t opcode, int dst, int src) {
+                Byte(prefix);
+                Rex(false, dst >= 8, false, src >= 8);
+                Bytes({0x0F, opcode, static_cast<uint8_t>(0xC0 | ((dst & 7) << 3) | (src & 7))});
+            }
+
+            // op xmm, [base + disp32]
+            void SseMemory(uint8_t prefix, uint8_t opcode, int reg, int base, int32_t disp) {
+                Byte(prefix);
+                Rex(false, reg >= 8, false, base >= 8);
+                Bytes({0x0F, opcode, static_cast<uint8_t>(0x80 | ((reg & 7) << 3) | (base & 7))});
+                if ((base & 7) == RSP) Byte(0x24);
+                Imm32(disp);
+            }
+
+            // op xmm, [base + index * 8]
+            void SseIndexed(uint8_t prefix, uint8_t opcode, int reg, int base, int index) {
+                Byte(prefix);
+                Rex(false, reg >= 8, index >= 8, base >= 8);
+                Bytes({0x0F, opcode, static_cast<uint8_t>(0x04 | ((reg & 7) << 3)),
+                       static_cast<uint8_t>(0xC0 | ((index & 7) << 3) | (base & 7))});
+            }
+
+            void MovRaxImm64(uint64_t value) {
+                Bytes({0x48, 0xB8});
+                Imm64(value);
+            }
+
+            void MovXmmFromRax(int xmm) {
+                Byte(0x66);
+                Rex(true, xmm >= 8, false, false);
+                Bytes({0x0F, 0x6E, static_cast<uint8_t>(0xC0 | ((xmm & 7) << 3))});
+            }
+
+            void MovRdiImm64(uint64_t value) {
+                Bytes({0x48, 0xBF});
+                Imm64(value);
+            }
+
+            void CallRax() { Bytes({0xFF, 0xD0}); }
+
+            size_t JumpPlaceholder(std::initializer_list<uint8_t> opcode) {
+                Bytes(opcode);
+                Imm32(0);
+                return Position() - 4;
+            }
+
+            void PatchJump(size_t placeholder, size_t target) {
+                int32_t relative = static_cast<int32_t>(target - (placeholder + 4));
+                std::memcpy(code_.data() + placeholder, &relative, sizeof(relative));
+            }
+
+        private:
+            std::vector<uint8_t> code_;
+        };
+
+        /*
+            Генерация функции по программе байт-кода. Скалярный вариант
+            (packed == false) вычисляет одну строку из массива ячеек,
+            пакетный - две строки из столбцов за итерацию цикла.
+        */
+        class Generator {
+        public:
+            Generator(const Bytecode::Program& program, Assembler& assembler, bool packed)
+                : program_(program), as_(assembler), packed_(packed) {}
+
+            void Generate() {
+                EmitPrologue();
+                size_t loop_start = 0;
+                size_t loop_exit = 0;
+                if (packed_) {
+                    // rdi = columns, rsi = out, rdx = begin, rcx = end
+                    as_.Bytes({0x48, 0x89, 0xFB});             // mov rbx, rdi
+                    as_.Bytes({0x49, 0x89, 0xF6});             // mov r14, rsi
+                    as_.Bytes({0x49, 0x89, 0xD4});             // mov r12, rdx
+                    as_.Bytes({0x49, 0x89, 0xCD});             // mov r13, rcx
+                    loop_start = as_.Position();
+                    as_.Bytes({0x49, 0x8D, 0x44, 0x24, 0x02}); // lea rax, [r12 + 2]
+                    as_.Bytes({0x4C, 0x39, 0xE8});             // cmp rax, r13
+                    loop_exit = as_.JumpPlaceholder({0x0F, 0x87}); // ja exit
+                } else {
+                    as_.Bytes({0x48, 0x89, 0xFB});             // mov rbx, rdi
+                }
+
+                int depth = 0;
+                for (const Bytecode::Instruction& instr : program_.code) {
+                    EmitInstruction(instr, depth);
+                }
+
+                if (packed_) {
+                    as_.SseIndexed(kPrefixPacked, kOpMovStore, 0, R14, R12); // movupd [r14 + r12*8], xmm0
+                    as_.Bytes({0x49, 0x83, 0xC4, 0x02});                      // add r12, 2
+                    size_t back = as_.JumpPlaceholder({0xE9});
+                    as_.PatchJump(back, loop_start);
+                    const size_t exit = as_.Position();
+                    as_.PatchJump(loop_exit, exit);
+                    for (size_t jump : error_jumps_) as_.PatchJump(jump, exit);
+                    as_.Bytes({0x4C, 0x89, 0xE0});                            // mov rax, r12
+                } else {
+                    size_t done = as_.JumpPlaceholder({0xE9});
+                    const size_t error = as_.Position();
+                    for (size_t jump : error_jumps_) as_.PatchJump(jump, error);
+                    as_.MovRaxImm64(BitsOf(NAN));
+                    as_.MovXmmFromRax(0);
+                    as_.PatchJump(done, as_.Position());
+                }
+                EmitEpilogue();
+            }
+
+        private:
+            uint8_t Prefix() const { return packed_ ? kPrefixPacked : kPrefixScalar; }
+
+            void EmitPrologue() {
+                as_.Byte(0x55);                          // push rbp
+                as_.Bytes({0x48, 0x89, 0xE5});           // mov rbp, rsp
+                as_.Byte(0x53);                          // push rbx
+                as_.Bytes({0x41, 0x54});                 // push r12
+                as_.Bytes({0x41, 0x55});                 // push r13
+                as_.Bytes({0x41, 0x56});                 // push r14
+                const int32_t frame = -TempOffset(static_cast<uint32_t>(program_.temp_count)) - kSavedRegistersSize;
+                as_.Bytes({0x48, 0x81, 0xEC});           // sub rsp, frame
+                as_.Imm32(frame);
+            }
+
+            void EmitEpilogue() {
+                as_.Bytes({0x48, 0x8D, 0x65, 0xE0});     // lea rsp, [rbp - 32]
+                as_.Bytes({0x41, 0x5E});                 // pop r14
+                as_.Bytes({0x41, 0x5D});                 // pop r13
+                as_.Bytes({0x41, 0x5C});                 // pop r12
+                as_.Byte(0x5B);                          // pop rbx
+                as_.Byte(0x5D);                          // pop rbp
+                as_.Byte(0xC3);                          // ret
+            }
+
+            void EmitInstruction(const Bytecode::Instruction& instr, int& depth) {
+                using Bytecode::OpCode;
+                switch (instr.op) {
+                    case OpCode::PUSH_CONST:
+                        LoadConstant(depth, BitsOf(instr.value));
+                        ++depth;
+                        break;
+                    case OpCode::LOAD_VAR:
+                        if (packed_) {
+                            as_.Bytes({0x48, 0x8B, 0x83});   // mov rax, [rbx + disp32]
+                            as_.Imm32(static_cast<int32_t>(8 * instr.operand));
+                            as_.SseIndexed(kPrefixPacked, kOpMovLoad, depth, RAX, R12);
+                        } else {
+                            as_.SseMemory(kPrefixScalar, kOpMovLoad, depth, RBX, static_cast<int32_t>(8 * instr.operand));
+                        }
+                        ++depth;
+                        break;
+                    case OpCode::ADD: Arithmetic(kOpAdd, depth); break;
+                    case OpCode::SUB: Arithmetic(kOpSub, depth); break;
+                    case OpCode::MUL: Arithmetic(kOpMul, depth); break;
+                    case OpCode::DIV: Arithmetic(kOpDiv, depth); break;
+                    case OpCode::POW:
+                        CallBinary(reinterpret_cast<uint64_t>(static_cast<double (*)(double, double)>(std::pow)), depth);
+                        --depth;
+                        CheckFinite(depth - 1);
+                        break;
+                    case OpCode::NEG:
+                        LoadConstant(kScratchXmm0, BitsOf(-0.0));
+                        as_.SseRegister(kPrefixPacked, kOpXor, depth - 1, kScratchXmm0);
+                        break;
+                    case OpCode::PLUS:
+                        break;
+                    case OpCode::FACTORIAL:
+                        CallUnary(reinterpret_cast<uint64_t>(&FactorialOrNan), depth);
+                        CheckFinite(depth - 1);
+                        break;
+                    case OpCode::CALL:
+                        CallUnary(reinterpret_cast<uint64_t>(&CallOrNan), depth,
+                                  reinterpret_cast<uint64_t>(program_.functions[instr.operand]));
+                        CheckFinite(depth - 1);
+                        break;
+                    case OpCode::STORE_TEMP:
+                        as_.SseMemory(kPrefixPacked, kOpMovStore, depth - 1, RBP, TempOffset(instr.operand));
+                        break;
+                    case OpCode::LOAD_TEMP:
+                        as_.SseMemory(kPrefixPacked, kOpMovLoad, depth, RBP, TempOffset(instr.operand));
+                        ++depth;
+                        break;
+                }
+            }
+
+            void LoadConstant(int xmm, uint64_t bits) {
+                as_.MovRaxImm64(bits);
+                as_.MovXmmFromRax(xmm);
+                if (packed_) {
+                    as_.SseRegister(kPrefixPacked, kOpUnpackLow, xmm, xmm);
+                }
+            }
+
+            void Arithmetic(uint8_t opcode, int& depth) {
+                as_.SseRegister(Prefix(), opcode, depth - 2, depth - 1);
+                --depth;
+                CheckFinite(depth - 1);
+            }
+
+            /*
+                Проверка конечности: x - x даёт NaN только для inf и NaN.
+                При ошибке управление передаётся на выход из функции.
+            */
+            void CheckFinite(int xmm) {
+                as_.SseRegister(kPrefixPacked, kOpMovAligned, kScratchXmm1, xmm);
+                as_.SseRegister(Prefix(), kOpSub, kScratchXmm1, kScratchXmm1);
+                if (packed_) {
+                    as_.Bytes({0x66, 0x45, 0x0F, 0xC2, 0xFF, 0x03});  // cmpunordpd xmm15, xmm15
+                    as_.Bytes({0x66, 0x41, 0x0F, kOpMoveMask, 0xC7}); // movmskpd eax, xmm15
+                    as_.Bytes({0x85, 0xC0});                          // test eax, eax
+                    error_jumps_.push_back(as_.JumpPlaceholder({0x0F, 0x85}));
+                } else {
+                    as_.SseRegister(kPrefixPacked, kOpCompareUnordered, kScratchXmm1, kScratchXmm1);
+                    error_jumps_.push_back(as_.JumpPlaceholder({0x0F, 0x8A}));
+                }
+            }
+
+            // Все регистры xmm не сохраняются при вызове, поэтому живые значения стека выгружаются в кадр
+            void Spill(int live) {
+                for (int i = 0; i < live; ++i) {
+                    as_.SseMemory(kPrefixPacked, kOpMovStore, i, RBP, SpillOffset(i));
+                }
+            }
+
+            void Reload(int live) {
+                for (int i = 0; i < live; ++i) {
+                    as_.SseMemory(kPrefixPacked, kOpMovLoad, i, RBP, SpillOffset(i));
+                }
+            }
+
+            // Ненулевой context передаётся вторым аргументом (rdi)
+            void CallFunction(uint64_t address, uint64_t context = 0) {
+                if (context != 0) as_.MovRdiImm64(context);
+                as_.MovRaxImm64(address);
+                as_.CallRax();
+            }
+
+            void CallUnary(uint64_t address, int depth, uint64_t context = 0) {
+                const int argument = depth - 1;
+                Spill(argument);
+                if (packed_) {
+                    as_.SseMemory(kPrefixPacked, kOpMovStore, argument, RBP, kArgumentOffset0);
+                    for (int32_t lane = 0; lane < 2; ++lane) {
+                        as_.SseMemory(kPrefixScalar, kOpMovLoad, 0, RBP, kArgumentOffset0 + 8 * lane);
+                        CallFunction(address, context);
+                        as_.SseMemory(kPrefixScalar, kOpMovStore, 0, RBP, kArgumentOffset0 + 8 * lane);
+                    }
+                    as_.SseMemory(kPrefixPacked, kOpMovLoad, argument, RBP, kArgumentOffset0);
+                } else {
+                    if (argument != 0) as_.SseRegister(kPrefixPacked, kOpMovAligned, 0, argument);
+                    CallFunction(address, context);
+                    if (argument != 0) as_.SseRegister(kPrefixPacked, kOpMovAligned, argument, 0);
+                }
+                Reload(argument);
+            }
+
+            void CallBinary(uint64_t address, int depth) {
+                const int left = depth - 2;
+                const int right = depth - 1;
+                Spill(left);
+                if (packed_) {
+                    as_.SseMemory(kPrefixPacked, kOpMovStore, left, RBP, kArgumentOffset0);
+                    as_.SseMemory(kPrefixPacked, kOpMovStore, right, RBP, kArgumentOffset1);
+                    for (int32_t lane = 0; lane < 2; ++lane) {
+                        as_.SseMemory(kPrefixScalar, kOpMovLoad, 0, RBP, kArgumentOffset0 + 8 * lane);
+                        as_.SseMemory(kPrefixScalar, kOpMovLoad, 1, RBP, kArgumentOffset1 + 8 * lane);
+                        CallFunction(address);
+                        as_.SseMemory(kPrefixScalar, kOpMovStore, 0, RBP, kArgumentOffset0 + 8 * lane);
+                    }
+                    as_.SseMemory(kPrefixPacked, kOpMovLoad, left, RBP, kArgumentOffset0);
+                } else {
+                    as_.SseRegister(kPrefixPacked, kOpMovAligned, kScratchXmm0, left);
+                    as_.SseRegister(kPrefixPacked, kOpMovAligned, kScratchXmm1, right);
+                    as_.SseRegister(kPrefixPacked, kOpMovAligned, 0, kScratchXmm0);
+                    as_.SseRegister(kPrefixPacked, kOpMovAligned, 1, kScratchXmm1);
+                    CallFunction(address);
+                    if (left != 0) as_.SseRegister(kPrefixPacked, kOpMovAligned, left, 0);
+                }
+                Reload(left);
+            }
+
+        private:
+            const Bytecode::Program& program_;
+            Assembler& as_;
+            bool packed_;
+            std::vector<size_t> error_jumps_;
+        };
+
+    } //End of anonymous namespace
+
+    CompiledFunction::~CompiledFunction() {
+        munmap(memory_, size_);
+    }
+
+    std::unique_ptr<CompiledFunction> CompiledFunction::Compile(const Bytecode::Program& program) {
+        if (program.code.empty() || program.max_stack_depth > static_cast<size_t>(kRegisterStackSize)) {
+            return nullptr;
+        }
+        Assembler assembler;
+        Generator(program, assembler, false).Generate();
+        /*
+            Пакетная функция не генерируется, если в программе есть функции с
+            векторной реализацией: блочный интерпретатор вычисляет их быстрее,
+            чем поэлементные вызовы из машинного кода.
+        */
+        const bool has_block_calls = std::any_of(program.block_functions.begin(), program.block_functions.end(),
+                                                 [](auto function) { return function != nullptr; });
+        const size_t batch_offset = assembler.Position();
+        if (!has_block_calls) {
+            Generator(program, assembler, true).Generate();
+        }
+
+        /* Код копируется в анонимное отображение, которое затем становится исполняемым */
+        std::vector<uint8_t>& code = assembler.GetCode();
+        void* memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return nullptr;
+        }
+        std::memcpy(memory, code.data(), code.size());
+        if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, code.size());
+            return nullptr;
+        }
+        auto* base = static_cast<uint8_t*>(memory);
+        return std::unique_ptr<CompiledFunction>(new CompiledFunction(
+            memory, code.size(),
+            reinterpret_cast<ScalarEntry>(base),
+            has_block_calls ? nullptr : reinterpret_cast<BatchEntry>(base + batch_offset)));
+    }
+
+    bool IsSupported() {
+        return true;
+    }
+
+#else
+
+    CompiledFunction::~CompiledFunction() {}
+
+    std::unique_ptr<CompiledFunction> CompiledFunction::Compile(const Bytecode::Program&) {
+        return nullptr;
+    }
+
+    bool IsSupported() {
+        return false;
+    }
+
+#endif
+
+} //End of namespace Jit
@@ -3,17 +3,45 @@
 #include <sstream>
 #include <string>
 #include <cctype>
+#include <charconv>
 #include <stdexcept>
+#include <limits>
 
 using namespace Token;
 
-Lexer::Lexer(const std::string& expression) 
-    : constants_(GetDefaultConstants()),
-      functions_(GetDefaultFunctions()),
-      expression_(expression) {}
+namespace {
 
-std::vector<Token_Param> Lexer::GetTokens() {
-    std::vector<Token_Param> tokens;
+    Token_Param MakeToken(TokenType type, size_t position, double number = 0.0) {
+        Token_Param token{type, static_cast<uint32_t>(position), {number}};
+        return token;
+    }
+
+    bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    Token_Param MakeIdentifier(TokenType type, size_t position, size_t length) {
+        Token_Param token = MakeToken(type, position);
+        token.length = static_cast<uint32_t>(length);
+        return token;
+    }
+
+} //End of anonymous namespace
+
+Lexer::Lexer(std::string_view expression, const FunctionRegistry& functions, std::pmr::memory_resource* resource)
+    : expression_(expression),
+      functions_(functions),
+      resource_(resource) {
+    // Позиции и длины токенов хранятся в 32 битах
+    if (expression_.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Expression is too long");
+    }
+}
+
+Tokens Lexer::GetTokens() {
+    Tokens tokens(resource_);
+    // Токенов не больше, чем символов, поэтому вектор не перевыделяется
+    tokens.reserve(expression_.size());
     size_t pos = 0;
     size_t length = expression_.size();
     
@@ -27,27 +55,8 @@ std::vector<Token_Param> Lexer::GetTokens() {
         }
         
         // Обработка чисел
-        if (isdigit(c) || c == '.') {
-            size_t start = pos;
-            bool has_dot = (c == '.');
-            
-            while (pos < length && (isdigit(expression_[pos]) || expression_[pos] == '.')) {
-                if (expression_[pos] == '.') {
-                    if (has_dot) {
-                        // В случае если в составе числа обнаружена вторая точка
-                        throw std::runtime_error("Invalid number format at position " + std::to_string(pos));
-                    }
-                    has_dot = true;
-                }
-                pos++;
-            }
-            
-            try {
-                double value = stod(expression_.substr(start, pos - start));
-                tokens.push_back({TokenType::NUMBER, value, start});
-            } catch (...) {
-                throw std::runtime_error("Invalid number at position " + std::to_string(start));
-            }
+        if (IsDigit(c) || c == '.') {
+            pos = ScanNumber(pos, tokens);
             continue;
         }
         
@@ -58,14 +67,14 @@ std::vector<Token_Param> Lexer::GetTokens() {
                 pos++;
             }
             
-            std::string ident = expression_.substr(start, pos - start);
+            std::string_view ident(expression_.data() + start, pos - start);
             
-            if (constants_.count(ident)) {
-                tokens.push_back({TokenType::CONSTANT, constants_.at(ident), start});
-            } else if (functions_.count(ident)) {
-                tokens.push_back({TokenType::FUNCTION, ident, start});
+            if (const ConstantEntry* constant = FindConstant(ident)) {
+                tokens.push_back(MakeToken(TokenType::CONSTANT, start, constant->value));
+            } else if (functions_.Find(ident) != nullptr) {
+                tokens.push_back(MakeIdentifier(TokenType::FUNCTION, start, ident.size()));
             } else {
-                tokens.push_back({TokenType::VARIABLE, ident, start});
+                tokens.push_back(MakeIdentifier(TokenType::VARIABLE, start, ident.size()));
             }
             continue;
         }
@@ -73,53 +82,53 @@ std::vector<Token_Param> Lexer::GetTokens() {
         // Обработка операторов
         switch (c) {
             case '+':
-                tokens.push_back({TokenType::PLUS, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::PLUS, pos));
                 pos++;
                 break;
             case '-':
-                tokens.push_back({TokenType::MINUS, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::MINUS, pos));
                 pos++;
                 break;
             case '*':
-                tokens.push_back({TokenType::MULTIPLY, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::MULTIPLY, pos));
                 pos++;
                 break;
             case '/':
-                tokens.push_back({TokenType::DIVIDE, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::DIVIDE, pos));
                 pos++;
                 break;
             case '^':
-                tokens.push_back({TokenType::POWER, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::POWER, pos));
                 pos++;
                 break;
             case '!':
-                tokens.push_back({TokenType::UNARY_FACTORIAL, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::UNARY_FACTORIAL, pos));
                 pos++;
                 break;
                 
             // Обработка скобок
             case '(':
-                tokens.push_back({TokenType::LEFT_PAREN, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::LEFT_PAREN, pos));
                 pos++;
                 break;
             case ')':
-                tokens.push_back({TokenType::RIGHT_PAREN, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::RIGHT_PAREN, pos));
                 pos++;
                 break;
             case '[':
-                tokens.push_back({TokenType::LEFT_BRACKET, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::LEFT_BRACKET, pos));
                 pos++;
                 break;
             case ']':
-                tokens.push_back({TokenType::RIGHT_BRACKET, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::RIGHT_BRACKET, pos));
                 pos++;
                 break;
             case '{':
-                tokens.push_back({TokenType::LEFT_BRACE, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::LEFT_BRACE, pos));
                 pos++;
                 break;
             case '}':
-                tokens.push_back({TokenType::RIGHT_BRACE, std::string(1, c), pos});
+                tokens.push_back(MakeToken(TokenType::RIGHT_BRACE, pos));
                 pos++;
                 break;
                 
@@ -133,7 +142,54 @@ std::vector<Token_Param> Lexer::GetTokens() {
     return tokens;
 }
 
-void Lexer::HandleUnaryOperators(std::vector<Token_Param>& tokens) {
+/*
+    Число имеет вид digits[.digits][(e|E)[+|-]digits], целая или дробная часть
+    может отсутствовать. Экспонента относится к числу, только если за e следуют
+    цифры, поэтому в 2e без показателя e остаётся отдельным идентификатором.
+    Значение разбирается на месте функцией from_chars с корректным округлением
+    и без зависимости от локали.
+*/
+size_t Lexer::ScanNumber(size_t pos, Tokens& tokens) const {
+    const size_t start = pos;
+    const size_t length = expression_.size();
+    bool has_dot = false;
+
+    while (pos < length && (IsDigit(expression_[pos]) || expression_[pos] == '.')) {
+        if (expression_[pos] == '.') {
+            if (has_dot) {
+                // В случае если в составе числа обнаружена вторая точка
+                throw std::runtime_error("Invalid number format at position " + std::to_string(pos));
+            }
+            has_dot = true;
+        }
+        pos++;
+    }
+
+    if (pos < length && (expression_[pos] == 'e' || expression_[pos] == 'E')) {
+        size_t exponent = pos + 1;
+        if (exponent < length && (expression_[exponent] == '+' || expression_[exponent] == '-')) {
+            exponent++;
+        }
+        if (exponent < length && IsDigit(expression_[exponent])) {
+            pos = exponent;
+            while (pos < length && IsDigit(expression_[pos])) {
+                pos++;
+            }
+        }
+    }
+
+    const char* first = expression_.data() + start;
+    const char* last = expression_.data() + pos;
+    double value = 0.0;
+    auto [end, error] = std::from_chars(first, last, value);
+    if (error != std::errc() || end != last) {
+        throw std::runtime_error("Invalid number at position " + std::to_string(start));
+    }
+    tokens.push_back(MakeToken(TokenType::NUMBER, start, value));
+    return pos;
+}
+
+void Lexer::HandleUnaryOperators(Tokens& tokens) {
     if (tokens.empty()) return;
     
     // Первый токен может быть унарным + или -
@@ -1,58 +1,164 @@
 #include "../include/CLI11.hpp"
+#include <arrow_evaluator.h>
+#include <arrow_ipc.h>
+#include <calculator_server.h>
+#include <atomic>
+#include <csignal>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <calculator.h>
+#include <csv_evaluator.h>
+#include <cstdio>
+#include <expression_cache.h>
+#include <file_io.h>
+#include <output_writer.h>
+#include <stream_evaluator.h>
+#include <variable_parser.h>
 
-using namespace std::string_literals;
-
-std::map<std::string, std::variant<double, std::string>> ParseVariables(std::vector<std::string>& raw_vars){
-    std::map<std::string, std::variant<double, std::string>> result_vars{};
-    if(!raw_vars.empty()) {
-        for(const auto& arg : raw_vars) {
-            std::string pair = arg;
-            size_t eq_pos = pair.find('=');
-            if(eq_pos == std::string::npos || eq_pos == 0 || eq_pos == pair.size()-1) {
-                throw std::runtime_error("Invalid variable format: "s + pair);
-            } else {
-                std::string name = pair.substr(0, eq_pos);
-                if(isdigit(pair.at(eq_pos + 1))) {
-                    double value{0.0};
-                    try {
-                        size_t var_symbols = pair.substr(eq_pos + 1).size();
-                        size_t var_digit_count{0};
-                        value = std::stod(pair.substr(eq_pos + 1), &var_digit_count);
-                        if(var_digit_count != var_symbols) {
-                            throw std::runtime_error("Invalid variable format: "s + pair);
-                        }
-                    } catch(const std::exception& e) {
-                        throw std::runtime_error("Invalid number format in: "s + pair);
-                    }
-                    result_vars[name] = value;
-                } else {
-                    result_vars[name] = pair.substr(eq_pos + 1);
-                }
-            }
+namespace {
+
+    std::atomic<CalculatorServer*> running_server{nullptr};
+
+    void StopServer(int) {
+        if (CalculatorServer* server = running_server.load()) {
+            server->Stop();
         }
     }
-    return result_vars;
-}
+
+    // SIGINT и SIGTERM останавливают сервер, пока он существует; при любом
+    // выходе из области, в том числе по исключению, обработчики снимаются
+    class StopOnSignal {
+    public:
+        explicit StopOnSignal(CalculatorServer& server) {
+            running_server = &server;
+            std::signal(SIGINT, StopServer);
+            std::signal(SIGTERM, StopServer);
+        }
+        ~StopOnSignal() {
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGTERM, SIG_DFL);
+            running_server = nullptr;
+        }
+        StopOnSignal(const StopOnSignal&) = delete;
+        StopOnSignal& operator=(const StopOnSignal&) = delete;
+    };
+
+} //End of anonymous namespace
 
 int main(int argc, char** argv) {
     CLI::App app{"Calculator"};
     // Используем библиотеку CLI11 для парсинга выражения и переменных
     std::string expression;
-    app.add_option("expression", expression, "Mathematical expression to evaluate")->required()->expected(1);
+    auto* expression_option = app.add_option("expression", expression, "Mathematical expression to evaluate")
+        ->expected(1);
     std::vector<std::string>raw_vars;
-    app.add_option("--var, -v", raw_vars, "Variable values (e.g., --var x=1.0 y=2.0)");
+    std::string expression_path;
+    auto* file_option = app.add_option("--file, -f", expression_path, "Read the expression from a file")
+        ->excludes(expression_option);
+    auto* var_option = app.add_option("--var, -v", raw_vars, "Variable values (e.g., --var x=1.0 y=2.0)");
+    bool stream = false;
+    app.add_flag("--stream", stream, "Evaluate newline-delimited expressions from stdin (e.g., 'x + y; x=1 y=2')")
+        ->excludes(expression_option)->excludes(file_option)->excludes(var_option);
+    std::string socket_path;
+    auto* serve_option = app.add_option("--serve", socket_path,
+                                        "Serve length-prefixed evaluation requests on a Unix domain socket")
+        ->excludes(expression_option)->excludes(file_option)->excludes(var_option)->excludes("--stream");
+    size_t cache_size = ExpressionCache::kDefaultCapacity;
+    auto* cache_size_option = app.add_option("--cache-size", cache_size,
+                                             "Compiled expressions kept by --stream and --serve");
+    std::string csv_path;
+    auto* csv_option = app.add_option("--csv", csv_path, "Evaluate the expression for every row of a CSV file")
+        ->excludes("--stream")->excludes(serve_option);
+    std::string arrow_path;
+    auto* arrow_option = app.add_option("--arrow", arrow_path,
+                                        "Evaluate the expression for every row of an Arrow IPC file of float64 columns")
+        ->excludes("--stream")->excludes(serve_option)->excludes(csv_option);
+    std::string output_path;
+    auto* output_option = app.add_option("--output, -o", output_path, "Output file for --csv or --arrow (stdout by default)");
+    std::string result_column = "result";
+    auto* result_column_option = app.add_option("--result-column", result_column,
+                                                "Name of the column added by --csv or --arrow");
+    int precision = OutputWriter::kShortest;
+    auto* precision_option = app.add_option("--precision", precision,
+                                            "Significant digits of printed results (shortest round-trip by default)")
+        ->check(CLI::Range(1, 17))->excludes(arrow_option)->excludes(serve_option);
+    bool binary = false;
+    auto* binary_option = app.add_flag("--binary", binary,
+                                       "Write --stream and --csv results as raw native-endian doubles")
+        ->excludes(precision_option);
+    CompileOptions options;
+    const std::map<std::string, Engine> engine_names{
+        {"tree", Engine::TREE_WALKER}, {"bytecode", Engine::BYTECODE}, {"jit", Engine::JIT}
+    };
+    app.add_option("--engine", options.engine, "Evaluation engine: tree, bytecode or jit")
+        ->transform(CLI::CheckedTransformer(engine_names, CLI::ignore_case));
 
     CLI11_PARSE(app, argc, argv);
+    if (!stream && serve_option->count() == 0 && expression_option->count() == 0 && file_option->count() == 0) {
+        return app.exit(CLI::RequiredError(expression_option->get_name()));
+    }
+    if (csv_option->count() == 0 && arrow_option->count() == 0 &&
+        (output_option->count() != 0 || result_column_option->count() != 0)) {
+        return app.exit(CLI::ValidationError("--output and --result-column require --csv or --arrow"));
+    }
+    if (!stream && csv_option->count() == 0 && binary_option->count() != 0) {
+        return app.exit(CLI::ValidationError("--binary requires --stream or --csv"));
+    }
+    if (!stream && serve_option->count() == 0 && cache_size_option->count() != 0) {
+        return app.exit(CLI::ValidationError("--cache-size requires --stream or --serve"));
+    }
 
     try{
-        std::map<std::string, std::variant<double, std::string>> variables;
-        variables = ParseVariables(raw_vars);
+        if (!socket_path.empty()) {
+            Calculator calc;
+            ExpressionCache cache(calc, options, cache_size);
+            CalculatorServer server(cache, socket_path);
+            StopOnSignal stop_on_signal(server);
+            server.Run();
+            return 0;
+        }
+        if (stream) {
+            Calculator calc;
+            ExpressionCache cache(calc, options, cache_size);
+            StreamEvaluator evaluator(cache);
+            FileIo::LineReader reader = FileIo::LineReader::Open(fileno(stdin));
+            OutputWriter writer(fileno(stdout), precision, binary);
+            evaluator.Run(reader, writer);
+            return 0;
+        }
+        Token::Variables variables;
+        variables = VariableParser::ParseVariables(raw_vars);
         Calculator calc;
-        double result = calc.Calculate(expression, variables);
-        std::cout << "Result: " << result << std::endl;
+        // Выражение из файла разбирается прямо из отображения в память
+        std::unique_ptr<FileIo::MappedFile> expression_file;
+        std::string_view expression_text = expression;
+        if (!expression_path.empty()) {
+            expression_file = std::make_unique<FileIo::MappedFile>(expression_path);
+            expression_text = expression_file->GetData();
+        }
+        if (!csv_path.empty()) {
+            const CompiledExpression compiled = calc.Compile(expression_text, options);
+            FileIo::LineReader input = FileIo::LineReader::OpenFile(csv_path);
+            FileIo::File output = output_path.empty() ? FileIo::File() : FileIo::File::OpenForWriting(output_path);
+            CsvEvaluator evaluator(compiled, std::move(variables), result_column);
+            OutputWriter writer(output_path.empty() ? fileno(stdout) : output.Get(), precision, binary);
+            evaluator.Run(input, writer);
+            return 0;
+        }
+        if (!arrow_path.empty()) {
+            const CompiledExpression compiled = calc.Compile(expression_text, options);
+            const Arrow::Reader input(arrow_path);
+            FileIo::File output = output_path.empty() ? FileIo::File() : FileIo::File::OpenForWriting(output_path);
+            ArrowEvaluator evaluator(compiled, std::move(variables), result_column);
+            evaluator.Run(input, output_path.empty() ? fileno(stdout) : output.Get());
+            return 0;
+        }
+        double result = calc.Compile(expression_text, options).Evaluate(variables);
+        std::string text = "Result: ";
+        OutputWriter::AppendNumber(text, result, precision);
+        std::cout << text << std::endl;
         return 0;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
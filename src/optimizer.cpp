@@ -0,0 +1,234 @@
+#include "optimizer.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Optimizer {
+
+    namespace {
+
+        /*
+            Свёртка констант: дерево перестраивается снизу вверх, и каждый узел,
+            все операнды которого после свёртки стали числами, вычисляется сразу
+            и заменяется на NumberNode. Ошибки вычисления (переполнение, факториал
+            и т.п.) возникают при компиляции с теми же сообщениями.
+            Порядок операций не меняется, поэтому в x * 2 * PI произведение
+            констант не сворачивается.
+        */
+        class ConstantFolder : public ASTVisitor {
+        public:
+            explicit ConstantFolder(std::pmr::memory_resource* resource) : resource_(resource) {}
+
+            std::shared_ptr<const ASTNode> Fold(const ASTNode& node) {
+                node.Accept(*this);
+                return std::move(result_);
+            }
+
+            void Visit(const NumberNode& node) override {
+                result_ = MakeNode<NumberNode>(resource_, node.GetValue());
+            }
+
+            void Visit(const VariableNode& node) override {
+                result_ = MakeNode<VariableNode>(resource_, node.GetName(), resource_);
+            }
+
+            void Visit(const BinaryOpNode& node) override {
+                // Левая цепочка сворачивается циклом снизу вверх
+                const size_t base = chain_.size();
+                for (const BinaryOpNode* link = &node; link != nullptr; link = link->GetLeftBinary()) {
+                    chain_.push_back(link);
+                }
+                auto left = Fold(chain_.back()->GetLeft());
+                for (size_t i = chain_.size(); i-- > base;) {
+                    const BinaryOpNode& link = *chain_[i];
+                    auto right = Fold(link.GetRight());
+                    const bool constant = IsNumber(*left) && IsNumber(*right);
+                    SetResult(MakeNode<BinaryOpNode>(resource_, link.GetOperatorType(), std::move(left),
+                                                     std::move(right)),
+                              constant);
+                    left = std::move(result_);
+                }
+                chain_.resize(base);
+                result_ = std::move(left);
+            }
+
+            void Visit(const UnaryOpNode& node) override {
+                auto operand = Fold(node.GetOperand());
+                const bool constant = IsNumber(*operand);
+                SetResult(MakeNode<UnaryOpNode>(resource_, node.GetOperatorType(), std::move(operand)), constant);
+            }
+
+            void Visit(const FunctionNode& node) override {
+                std::shared_ptr<const ASTNode> argument;
+                if (node.GetArgument() != nullptr) {
+                    argument = Fold(*node.GetArgument());
+                }
+                const bool constant = argument == nullptr || IsNumber(*argument);
+                SetResult(MakeNode<FunctionNode>(resource_, node.GetName(), node.GetFunction(), std::move(argument),
+                                                 resource_),
+                          constant);
+            }
+
+        private:
+            static bool IsNumber(const ASTNode& node) {
+                return dynamic_cast<const NumberNode*>(&node) != nullptr;
+            }
+
+            void SetResult(std::shared_ptr<const ASTNode> node, bool constant) {
+                if (constant) {
+                    result_ = MakeNode<NumberNode>(resource_, node->Evaluate({}));
+                } else {
+                    result_ = std::move(node);
+                }
+            }
+
+        private:
+            std::pmr::memory_resource* resource_;
+            std::shared_ptr<const ASTNode> result_;
+            // Узлы обрабатываемых левых цепочек, общий стек для вложенных вызовов
+            std::vector<const BinaryOpNode*> chain_;
+        };
+
+        /*
+            Устранение общих подвыражений методом hash-consing: дерево обходится
+            снизу вверх, и для каждого узла ищется уже встреченный структурно
+            равный узел. Поскольку потомки к этому моменту уже канонические,
+            равенство узлов сводится к равенству их полей и указателей на потомков.
+            В результате одинаковые поддеревья становятся одним общим узлом (DAG).
+            Каждый узел DAG создаётся в resource заново, поэтому исходное дерево
+            может жить во временной памяти и освобождаться сразу после прохода.
+        */
+        class SubexpressionMerger : public ASTVisitor {
+        public:
+            explicit SubexpressionMerger(std::pmr::memory_resource* resource) : resource_(resource) {}
+
+            std::shared_ptr<const ASTNode> Merge(const ASTNode& node) {
+                node.Accept(*this);
+                return std::move(result_);
+            }
+
+            size_t GetTreeNodes() const { return tree_nodes_; }
+            size_t GetDagNodes() const { return nodes_.size(); }
+
+            void Visit(const NumberNode& node) override {
+                const double value = node.GetValue();
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                Intern({Kind::NUMBER, Token::TokenType::NUMBER, bits, {}, nullptr, nullptr},
+                       [&] { return MakeNode<NumberNode>(resource_, value); });
+            }
+
+            void Visit(const VariableNode& node) override {
+                Intern({Kind::VARIABLE, Token::TokenType::VARIABLE, 0, std::string(node.GetName()), nullptr, nullptr},
+                       [&] { return MakeNode<VariableNode>(resource_, node.GetName(), resource_); });
+            }
+
+            void Visit(const BinaryOpNode& node) override {
+                // Левая цепочка объединяется циклом снизу вверх
+                const size_t base = chain_.size();
+                for (const BinaryOpNode* link = &node; link != nullptr; link = link->GetLeftBinary()) {
+                    chain_.push_back(link);
+                }
+                auto left = Merge(chain_.back()->GetLeft());
+                for (size_t i = chain_.size(); i-- > base;) {
+                    const Token::TokenType operator_type = chain_[i]->GetOperatorType();
+                    auto right = Merge(chain_[i]->GetRight());
+                    Intern({Kind::BINARY, operator_type, 0, {}, left.get(), right.get()},
+                           [&] { return MakeNode<BinaryOpNode>(resource_, operator_type, left, right); });
+                    left = std::move(result_);
+                }
+                chain_.resize(base);
+                result_ = std::move(left);
+            }
+
+            void Visit(const UnaryOpNode& node) override {
+                auto operand = Merge(node.GetOperand());
+                Intern({Kind::UNARY, node.GetOperatorType(), 0, {}, operand.get(), nullptr},
+                       [&] { return MakeNode<UnaryOpNode>(resource_, node.GetOperatorType(), operand); });
+            }
+
+            void Visit(const FunctionNode& node) override {
+                std::shared_ptr<const ASTNode> argument;
+                if (node.GetArgument() != nullptr) {
+                    argument = Merge(*node.GetArgument());
+                }
+                Intern({Kind::FUNCTION, Token::TokenType::FUNCTION, 0, std::string(node.GetName()), argument.get(), nullptr},
+                       [&] {
+                           return MakeNode<FunctionNode>(resource_, node.GetName(), node.GetFunction(), argument,
+                                                         resource_);
+                       });
+            }
+
+        private:
+            enum class Kind { NUMBER, VARIABLE, BINARY, UNARY, FUNCTION };
+
+            struct Key {
+                Kind kind;
+                Token::TokenType operator_type;
+                uint64_t value_bits;
+                std::string name;
+                const ASTNode* first;
+                const ASTNode* second;
+
+                bool operator==(const Key& other) const {
+                    return kind == other.kind && operator_type == other.operator_type &&
+                           value_bits == other.value_bits && name == other.name &&
+                           first == other.first && second == other.second;
+                }
+            };
+
+            struct KeyHash {
+                size_t operator()(const Key& key) const {
+                    size_t hash = std::hash<std::string>()(key.name);
+                    auto combine = [&hash](size_t value) {
+                        hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+                    };
+                    combine(static_cast<size_t>(key.kind));
+                    combine(static_cast<size_t>(key.operator_type));
+                    combine(std::hash<uint64_t>()(key.value_bits));
+                    combine(std::hash<const ASTNode*>()(key.first));
+                    combine(std::hash<const ASTNode*>()(key.second));
+                    return hash;
+                }
+            };
+
+            // Узел создаётся функцией make, только если равного ему ещё нет
+            template <typename Make>
+            void Intern(Key key, Make make) {
+                ++tree_nodes_;
+                auto [it, inserted] = nodes_.try_emplace(std::move(key));
+                if (inserted) {
+                    it->second = make();
+                }
+                result_ = it->second;
+            }
+
+        private:
+            std::pmr::memory_resource* resource_;
+            std::unordered_map<Key, std::shared_ptr<const ASTNode>, KeyHash> nodes_;
+            std::shared_ptr<const ASTNode> result_;
+            std::vector<const BinaryOpNode*> chain_;
+            size_t tree_nodes_ = 0;
+        };
+
+    } //End of anonymous namespace
+
+    std::shared_ptr<const ASTNode> FoldConstants(const ASTNode& root, std::pmr::memory_resource* resource) {
+        return ConstantFolder(resource).Fold(root);
+    }
+
+    std::shared_ptr<const ASTNode> EliminateCommonSubexpressions(const ASTNode& root, CseStats* stats,
+                                                                 std::pmr::memory_resource* resource) {
+        SubexpressionMerger merger(resource);
+        auto dag = merger.Merge(root);
+        if (stats != nullptr) {
+            stats->tree_nodes = merger.GetTreeNodes();
+            stats->dag_nodes = merger.GetDagNodes();
+        }
+        return dag;
+    }
+
+} //End of namespace Optimizer
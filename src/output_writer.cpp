@@ -0,0 +1,31 @@
+#include "output_writer.h"
+#include "file_io.h"
+#include <charconv>
+#include <limits>
+
+OutputWriter::OutputWriter(int fd, int precision, bool binary)
+    : fd_(fd), precision_(precision), binary_(binary) {
+    buffer_.reserve(kBufferSize);
+}
+
+void OutputWriter::AppendNumber(std::string& out, double value, int precision) {
+    // Самая длинная запись: знак, 17 цифр, точка и порядок вида e-308
+    char buffer[std::numeric_limits<double>::max_digits10 + 16];
+    const std::to_chars_result result = precision == kShortest
+        ? std::to_chars(buffer, buffer + sizeof(buffer), value)
+        : std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, precision);
+    out.append(buffer, result.ptr);
+}
+
+void OutputWriter::WriteNumber(double value) {
+    if (binary_) {
+        buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        return;
+    }
+    AppendNumber(buffer_, value, precision_);
+}
+
+void OutputWriter::Flush() {
+    FileIo::WriteAll(fd_, buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
@@ -1,12 +1,16 @@
 #include "parser.h"
+#include <algorithm>
 #include <stdexcept>
+#include <string>
 #include <memory>
 
 using namespace Token;
 
-Parser::Parser(const std::vector<Token_Param>& tokens) : tokens_(tokens) {}
+Parser::Parser(const Tokens& tokens, std::string_view expression, const FunctionRegistry& functions,
+               std::pmr::memory_resource* resource)
+    : tokens_(tokens), expression_(expression), functions_(functions), resource_(resource) {}
 
-std::unique_ptr<ASTNode> Parser::Parse() {
+std::shared_ptr<const ASTNode> Parser::Parse() {
     try {
         return ParseExpression();
     } catch (const std::exception& e) {
@@ -47,6 +51,19 @@ bool Parser::Check(TokenType type) const {
 bool Parser::IsAtEnd() const {
     return current_pos_ >= tokens_.size();
 }
+
+size_t Parser::Nest(size_t operand_depth) {
+    if (operand_depth >= kMaxDepth) {
+        throw std::runtime_error("Expression is nested deeper than " + std::to_string(kMaxDepth) + " levels");
+    }
+    return operand_depth + 1;
+}
+
+void Parser::EnterNesting() {
+    if (++nesting_ > kMaxDepth) {
+        throw std::runtime_error("Brackets are nested deeper than " + std::to_string(kMaxDepth) + " levels");
+    }
+}
 /*
     Парсинг строится на вызове функций:
     ParseAdditiveOp --> ParseMultiplicativeOp --> ParsePowerOp --> ParseUnaryOp
@@ -65,56 +82,67 @@ bool Parser::IsAtEnd() const {
     унарные операторы(-, +, !)
     числа, переменные, константы, функции, скобки
 */
-std::unique_ptr<ASTNode> Parser::ParseExpression() {
+std::shared_ptr<const ASTNode> Parser::ParseExpression() {
     return ParseAdditiveOp();
 }
 
-std::unique_ptr<ASTNode> Parser::ParseAdditiveOp() {
+std::shared_ptr<const ASTNode> Parser::ParseAdditiveOp() {
     auto expr = ParseMultiplicativeOp();
+    size_t depth = depth_;
     
     while (Check(TokenType::PLUS) || Check(TokenType::MINUS)) {
         Token_Param op = tokens_[current_pos_];
         Advance();
         auto right = ParseMultiplicativeOp();
-        expr = std::make_unique<BinaryOpNode>(op.type, std::move(expr), std::move(right));
+        // Левый операнд продолжает цепочку, вложенным считается только правый
+        depth = std::max(depth, Nest(depth_));
+        expr = MakeNode<BinaryOpNode>(resource_, op.type, std::move(expr), std::move(right));
     }
     
+    depth_ = depth;
     return expr;
 }
 
-std::unique_ptr<ASTNode> Parser::ParseMultiplicativeOp() {
+std::shared_ptr<const ASTNode> Parser::ParseMultiplicativeOp() {
     auto left = ParsePowerOp();
+    size_t depth = depth_;
     
     while (Check(TokenType::MULTIPLY) || Check(TokenType::DIVIDE)) {
         Token_Param op = tokens_[current_pos_];
         Advance();
         auto right = ParsePowerOp();
-        left = std::make_unique<BinaryOpNode>(op.type, std::move(left), std::move(right));
+        depth = std::max(depth, Nest(depth_));
+        left = MakeNode<BinaryOpNode>(resource_, op.type, std::move(left), std::move(right));
     }
     
+    depth_ = depth;
     return left;
 }
 
-std::unique_ptr<ASTNode> Parser::ParsePowerOp() {
+std::shared_ptr<const ASTNode> Parser::ParsePowerOp() {
     auto left = ParseUnaryOp();
+    size_t depth = depth_;
 
     while (Check(TokenType::POWER)) {
         Token_Param op = tokens_[current_pos_];
         Advance();
         auto right = ParseUnaryOp();
-        left = std::make_unique<BinaryOpNode>(op.type, std::move(left), move(right));
+        depth = std::max(depth, Nest(depth_));
+        left = MakeNode<BinaryOpNode>(resource_, op.type, std::move(left), std::move(right));
     }
     
+    depth_ = depth;
     return left;
 }
 
-std::unique_ptr<ASTNode> Parser::ParseUnaryOp() {
+std::shared_ptr<const ASTNode> Parser::ParseUnaryOp() {
     // Обработка унарных префиксных операторов
     if (Check(TokenType::UNARY_PLUS) || Check(TokenType::UNARY_MINUS)) {
         Token_Param op = tokens_[current_pos_];
         Advance();
         auto operand = ParsePrimaryExpr();
-        return std::make_unique<UnaryOpNode>(op.type, std::move(operand));
+        depth_ = Nest(depth_);
+        return MakeNode<UnaryOpNode>(resource_, op.type, std::move(operand));
     }
 
     auto primary = ParsePrimaryExpr();
@@ -123,47 +151,59 @@ std::unique_ptr<ASTNode> Parser::ParseUnaryOp() {
     while (Check(TokenType::UNARY_FACTORIAL)) {
         Token_Param op = tokens_[current_pos_];
         Advance();
-        primary = std::make_unique<UnaryOpNode>(op.type, std::move(primary));
+        depth_ = Nest(depth_);
+        primary = MakeNode<UnaryOpNode>(resource_, op.type, std::move(primary));
     }
     
     return primary;
 }
 
-std::unique_ptr<ASTNode> Parser::ParseFunctionCall(const std::string& name) {
+std::shared_ptr<const ASTNode> Parser::ParseFunctionCall(std::string_view name) {
+    const FunctionEntry* function = functions_.Find(name);
+    if (function == nullptr) {
+        throw std::runtime_error("Unknown function: " + std::string(name));
+    }
     Match(TokenType::LEFT_PAREN, "Expected '(' after function name");
+    EnterNesting();
     
-    std::unique_ptr<ASTNode> args;
+    std::shared_ptr<const ASTNode> args;
+    depth_ = 0;
     if (!Check(TokenType::RIGHT_PAREN)) {
         // в случае если будет несколько аргументов
-        args = std::move(ParseExpression());
+        args = ParseExpression();
     }
     
     Match(TokenType::RIGHT_PAREN, "Expected ')' after function arguments");
+    --nesting_;
+    depth_ = Nest(depth_);
     
-    return std::make_unique<FunctionNode>(name, move(args));
+    return MakeNode<FunctionNode>(resource_, name, *function, std::move(args), resource_);
 }
 
-std::unique_ptr<ASTNode> Parser::ParsePrimaryExpr() {
+std::shared_ptr<const ASTNode> Parser::ParsePrimaryExpr() {
     if (Check(TokenType::NUMBER)) {
-        double value = std::get<double>(tokens_[current_pos_].value);
+        double value = tokens_[current_pos_].number;
         Advance();
-        return std::make_unique<NumberNode>(value);
+        depth_ = 0;
+        return MakeNode<NumberNode>(resource_, value);
     }
     
     if (Check(TokenType::VARIABLE)) {
-        std::string name = std::get<std::string>(tokens_[current_pos_].value);
+        std::string_view name = tokens_[current_pos_].GetText(expression_);
         Advance();
-        return std::make_unique<VariableNode>(name);
+        depth_ = 0;
+        return MakeNode<VariableNode>(resource_, name, resource_);
     }
     
     if (Check(TokenType::CONSTANT)) {
-        double value = std::get<double>(tokens_[current_pos_].value);
+        double value = tokens_[current_pos_].number;
         Advance();
-        return std::make_unique<NumberNode>(value);
+        depth_ = 0;
+        return MakeNode<NumberNode>(resource_, value);
     }
     
     if (Check(TokenType::FUNCTION)) {
-        std::string name = std::get<std::string>(tokens_[current_pos_].value);
+        std::string_view name = tokens_[current_pos_].GetText(expression_);
         Advance();
         return ParseFunctionCall(name);
     }
@@ -171,17 +211,22 @@ std::unique_ptr<ASTNode> Parser::ParsePrimaryExpr() {
     if (Check(TokenType::LEFT_PAREN) || Check(TokenType::LEFT_BRACKET) || Check(TokenType::LEFT_BRACE)) {
         TokenType bracket_type = Peek().type;
         Advance(); // Пропускаем открывающую скобку
+        EnterNesting();
         
         auto expr = ParseExpression();
         
-        if (!IsMatchingBracket(bracket_type, Peek().type)) {
+        if (IsAtEnd() || !IsMatchingBracket(bracket_type, Peek().type)) {
             throw std::runtime_error("Mismatched brackets");
         }
         Advance(); // Пропускаем закрывающую скобку
+        --nesting_;
         
         return expr;
     }
     
+    if (IsAtEnd()) {
+        throw std::runtime_error("Unexpected end of expression");
+    }
     throw std::runtime_error("Unexpected token at position " + std::to_string(Peek().position));
 }
 
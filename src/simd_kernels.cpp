@@ -0,0 +1,487 @@
+#include "simd_kernels.h"
+#include <cmath>
+#include <cstdlib>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CALCULATOR_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Simd {
+
+    namespace {
+
+        enum class BinaryKind { ADD, SUBTRACT, MULTIPLY, DIVIDE };
+
+        template <BinaryKind kind>
+        inline double ApplyScalar(double left, double right) {
+            if constexpr (kind == BinaryKind::ADD) return left + right;
+            if constexpr (kind == BinaryKind::SUBTRACT) return left - right;
+            if constexpr (kind == BinaryKind::MULTIPLY) return left * right;
+            return left / right;
+        }
+
+        // Обработка хвоста блока, не кратного ширине вектора
+        template <BinaryKind kind>
+        bool BinaryScalar(double* left, const double* right, size_t begin, size_t count) {
+            bool finite = true;
+            for (size_t i = begin; i < count; ++i) {
+                left[i] = ApplyScalar<kind>(left[i], right[i]);
+                finite &= std::isfinite(left[i]);
+            }
+            return finite;
+        }
+
+        // Выборка из таблицы до первого значения, не являющегося допустимым индексом
+        size_t GatherScalar(double* values, const double* table, size_t table_size, size_t begin, size_t count) {
+            for (size_t i = begin; i < count; ++i) {
+                const double index = values[i];
+                if (!(index >= 0.0 && index < static_cast<double>(table_size)) || index != std::floor(index)) {
+                    return i;
+                }
+                values[i] = table[static_cast<size_t>(index)];
+            }
+            return count;
+        }
+
+#ifdef CALCULATOR_SIMD_X86
+
+        template <BinaryKind kind>
+        inline __m128d ApplySse2(__m128d left, __m128d right) {
+            if constexpr (kind == BinaryKind::ADD) return _mm_add_pd(left, right);
+            if constexpr (kind == BinaryKind::SUBTRACT) return _mm_sub_pd(left, right);
+            if constexpr (kind == BinaryKind::MULTIPLY) return _mm_mul_pd(left, right);
+            return _mm_div_pd(left, right);
+        }
+
+        /*
+            Конечность проверяется маской |x| < inf, которая ложна и для
+            бесконечностей, и для NaN. Маски накапливаются по всему блоку и
+            сводятся к одному флагу только в конце.
+        */
+        template <BinaryKind kind>
+        bool BinarySse2(double* left, const double* right, size_t count) {
+            const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+            const __m128d infinity = _mm_set1_pd(INFINITY);
+            __m128d finite = _mm_castsi128_pd(_mm_set1_epi64x(-1));
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                __m128d result = ApplySse2<kind>(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i));
+                _mm_storeu_pd(left + i, result);
+                finite = _mm_and_pd(finite, _mm_cmplt_pd(_mm_and_pd(result, abs_mask), infinity));
+            }
+            bool all_finite = _mm_movemask_pd(finite) == 0x3;
+            return BinaryScalar<kind>(left, right, i, count) && all_finite;
+        }
+
+        void NegateSse2(double* values, size_t count) {
+            const __m128d sign_mask = _mm_set1_pd(-0.0);
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                _mm_storeu_pd(values + i, _mm_xor_pd(_mm_loadu_pd(values + i), sign_mask));
+            }
+            for (; i < count; ++i) {
+                values[i] = -values[i];
+            }
+        }
+
+        bool AllFiniteSse2(const double* values, size_t count) {
+            const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+            const __m128d infinity = _mm_set1_pd(INFINITY);
+            __m128d finite = _mm_castsi128_pd(_mm_set1_epi64x(-1));
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                finite = _mm_and_pd(finite, _mm_cmplt_pd(_mm_and_pd(_mm_loadu_pd(values + i), abs_mask), infinity));
+            }
+            bool all_finite = _mm_movemask_pd(finite) == 0x3;
+            for (; i < count; ++i) {
+                all_finite &= std::isfinite(values[i]);
+            }
+            return all_finite;
+        }
+
+        /*
+            Индекс допустим, если он лежит в [0, table_size) и совпадает со своим
+            целочисленным представлением; NaN отсекается упорядоченными сравнениями.
+            В SSE2 нет инструкции выборки, поэтому элементы загружаются по
+            вычисленным индексам по одному.
+        */
+        size_t GatherSse2(double* values, size_t count, const double* table, size_t table_size) {
+            const __m128d zero = _mm_setzero_pd();
+            const __m128d limit = _mm_set1_pd(static_cast<double>(table_size));
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                const __m128d x = _mm_loadu_pd(values + i);
+                const __m128i index = _mm_cvttpd_epi32(x);
+                __m128d valid = _mm_and_pd(_mm_cmpge_pd(x, zero), _mm_cmplt_pd(x, limit));
+                valid = _mm_and_pd(valid, _mm_cmpeq_pd(_mm_cvtepi32_pd(index), x));
+                if (_mm_movemask_pd(valid) != 0x3) {
+                    return i;
+                }
+                values[i] = table[_mm_cvtsi128_si32(index)];
+                values[i + 1] = table[_mm_cvtsi128_si32(_mm_srli_si128(index, 4))];
+            }
+            return GatherScalar(values, table, table_size, i, count);
+        }
+
+#if defined(__GNUC__)
+#define CALCULATOR_SIMD_AVX 1
+
+        template <BinaryKind kind>
+        __attribute__((target("avx"))) inline __m256d ApplyAvx(__m256d left, __m256d right) {
+            if constexpr (kind == BinaryKind::ADD) return _mm256_add_pd(left, right);
+            if constexpr (kind == BinaryKind::SUBTRACT) return _mm256_sub_pd(left, right);
+            if constexpr (kind == BinaryKind::MULTIPLY) return _mm256_mul_pd(left, right);
+            return _mm256_div_pd(left, right);
+        }
+
+        template <BinaryKind kind>
+        __attribute__((target("avx"))) bool BinaryAvx(double* left, const double* right, size_t count) {
+            const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+            const __m256d infinity = _mm256_set1_pd(INFINITY);
+            __m256d finite = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m256d result = ApplyAvx<kind>(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i));
+                _mm256_storeu_pd(left + i, result);
+                finite = _mm256_and_pd(finite, _mm256_cmp_pd(_mm256_and_pd(result, abs_mask), infinity, _CMP_LT_OQ));
+            }
+            bool all_finite = _mm256_movemask_pd(finite) == 0xF;
+            return BinaryScalar<kind>(left, right, i, count) && all_finite;
+        }
+
+        __attribute__((target("avx"))) void NegateAvx(double* values, size_t count) {
+            const __m256d sign_mask = _mm256_set1_pd(-0.0);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                _mm256_storeu_pd(values + i, _mm256_xor_pd(_mm256_loadu_pd(values + i), sign_mask));
+            }
+            for (; i < count; ++i) {
+                values[i] = -values[i];
+            }
+        }
+
+        __attribute__((target("avx"))) bool AllFiniteAvx(const double* values, size_t count) {
+            const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+            const __m256d infinity = _mm256_set1_pd(INFINITY);
+            __m256d finite = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                finite = _mm256_and_pd(finite,
+                    _mm256_cmp_pd(_mm256_and_pd(_mm256_loadu_pd(values + i), abs_mask), infinity, _CMP_LT_OQ));
+            }
+            bool all_finite = _mm256_movemask_pd(finite) == 0xF;
+            for (; i < count; ++i) {
+                all_finite &= std::isfinite(values[i]);
+            }
+            return all_finite;
+        }
+
+        __attribute__((target("avx"))) inline bool ValidIndicesAvx(__m256d x, __m256d limit, __m128i index) {
+            __m256d valid = _mm256_and_pd(_mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_GE_OQ),
+                                          _mm256_cmp_pd(x, limit, _CMP_LT_OQ));
+            valid = _mm256_and_pd(valid, _mm256_cmp_pd(_mm256_cvtepi32_pd(index), x, _CMP_EQ_OQ));
+            return _mm256_movemask_pd(valid) == 0xF;
+        }
+
+        __attribute__((target("avx"))) size_t GatherAvx(double* values, size_t count, const double* table,
+                                                        size_t table_size) {
+            const __m256d limit = _mm256_set1_pd(static_cast<double>(table_size));
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m256d x = _mm256_loadu_pd(values + i);
+                const __m128i index = _mm256_cvttpd_epi32(x);
+                if (!ValidIndicesAvx(x, limit, index)) {
+                    return i;
+                }
+                values[i] = table[_mm_extract_epi32(index, 0)];
+                values[i + 1] = table[_mm_extract_epi32(index, 1)];
+                values[i + 2] = table[_mm_extract_epi32(index, 2)];
+                values[i + 3] = table[_mm_extract_epi32(index, 3)];
+            }
+            return GatherScalar(values, table, table_size, i, count);
+        }
+
+        // AVX2 добавляет аппаратную выборку по вектору индексов
+        __attribute__((target("avx2"))) size_t GatherAvx2(double* values, size_t count, const double* table,
+                                                          size_t table_size) {
+            const __m256d limit = _mm256_set1_pd(static_cast<double>(table_size));
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m256d x = _mm256_loadu_pd(values + i);
+                const __m128i index = _mm256_cvttpd_epi32(x);
+                if (!ValidIndicesAvx(x, limit, index)) {
+                    return i;
+                }
+                // Форма с маской и явным начальным значением: в _mm256_i32gather_pd GCC
+                // видит неинициализированный регистр и выдаёт -Wmaybe-uninitialized
+                const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+                _mm256_storeu_pd(values + i,
+                                 _mm256_mask_i32gather_pd(_mm256_setzero_pd(), table, index, all, sizeof(double)));
+            }
+            return GatherScalar(values, table, table_size, i, count);
+        }
+
+#endif
+#endif
+
+        void NegateScalar(double* values, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                values[i] = -values[i];
+            }
+        }
+
+        bool AllFiniteScalar(const double* values, size_t count) {
+            bool all_finite = true;
+            for (size_t i = 0; i < count; ++i) {
+                all_finite &= std::isfinite(values[i]);
+            }
+            return all_finite;
+        }
+
+        size_t GatherPortable(double* values, size_t count, const double* table, size_t table_size) {
+            return GatherScalar(values, table, table_size, 0, count);
+        }
+
+        template <BinaryKind kind>
+        bool BinaryPortable(double* left, const double* right, size_t count) {
+            return BinaryScalar<kind>(left, right, 0, count);
+        }
+
+        /* Константы приведения аргумента и многочлены ядер sin/cos из fdlibm */
+        constexpr double kTwoOverPi = 6.36619772367581382433e-01;
+        constexpr double kPio2Part1 = 1.57079632673412561417e+00;
+        constexpr double kPio2Part2 = 6.07710050630396597660e-11;
+        constexpr double kPio2Part3 = 2.02226624871116645580e-21;
+        constexpr double kMaxReducible = 1647099.0;
+        constexpr double kRoundMagic = 6755399441055744.0;
+        constexpr double kTinyArgument = 7.450580596923828125e-9;
+
+        constexpr double kS1 = -1.66666666666666324348e-01;
+        constexpr double kS2 = 8.33333333332248946124e-03;
+        constexpr double kS3 = -1.98412698298579493134e-04;
+        constexpr double kS4 = 2.75573137070700676789e-06;
+        constexpr double kS5 = -2.50507602534068634195e-08;
+        constexpr double kS6 = 1.58969099521155010221e-10;
+
+        constexpr double kC1 = 4.16666666666666019037e-02;
+        constexpr double kC2 = -1.38888888888741095749e-03;
+        constexpr double kC3 = 2.48015872894767294178e-05;
+        constexpr double kC4 = -2.75573143513906633035e-07;
+        constexpr double kC5 = 2.08757232129817482790e-09;
+        constexpr double kC6 = -1.13596475577881948265e-11;
+
+        /*
+            Скалярная версия повторяет векторную операцию в операцию, поэтому
+            результат не зависит от того, в какую часть блока попал элемент.
+            Квадрант вычисляется в double: q = n - 4 * floor(n / 4).
+        */
+        template <bool is_cos>
+        double SinCosScalar(double x) {
+            if (!(std::fabs(x) <= kMaxReducible)) {
+                return is_cos ? std::cos(x) : std::sin(x);
+            }
+            // Для малых аргументов sin(x) == x с точностью до округления, в том числе для -0.0
+            if (!is_cos && std::fabs(x) < kTinyArgument) {
+                return x;
+            }
+            const double n = (x * kTwoOverPi + kRoundMagic) - kRoundMagic;
+            const double r = ((x - n * kPio2Part1) - n * kPio2Part2) - n * kPio2Part3;
+            double quadrant = n - 4.0 * (((n * 0.25 - 0.375) + kRoundMagic) - kRoundMagic);
+            if (is_cos) {
+                quadrant = quadrant + 1.0;
+            }
+            const double z = r * r;
+            const double sin_value = r + (z * r) * (kS1 + z * (kS2 + z * (kS3 + z * (kS4 + z * (kS5 + z * kS6)))));
+            const double half_z = 0.5 * z;
+            const double w = 1.0 - half_z;
+            const double cos_value = w + (((1.0 - w) - half_z) +
+                (z * z) * (kC1 + z * (kC2 + z * (kC3 + z * (kC4 + z * (kC5 + z * kC6))))));
+            const bool odd = quadrant == 1.0 || quadrant == 3.0;
+            const bool negative = quadrant == 2.0 || quadrant == 3.0;
+            const double result = odd ? cos_value : sin_value;
+            return negative ? -result : result;
+        }
+
+        template <bool is_cos>
+        void SinCosPortable(double* values, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                values[i] = SinCosScalar<is_cos>(values[i]);
+            }
+        }
+
+#ifdef CALCULATOR_SIMD_AVX
+
+        template <bool is_cos>
+        __attribute__((target("avx"))) void SinCosAvx(double* values, size_t count) {
+            const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+            const __m256d sign_mask = _mm256_set1_pd(-0.0);
+            const __m256d magic = _mm256_set1_pd(kRoundMagic);
+            const __m256d one = _mm256_set1_pd(1.0);
+            const __m256d two = _mm256_set1_pd(2.0);
+            const __m256d three = _mm256_set1_pd(3.0);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m256d x = _mm256_loadu_pd(values + i);
+                const __m256d out_of_range = _mm256_cmp_pd(_mm256_and_pd(x, abs_mask),
+                                                           _mm256_set1_pd(kMaxReducible), _CMP_NLE_UQ);
+                const __m256d n = _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(x, _mm256_set1_pd(kTwoOverPi)), magic), magic);
+                __m256d r = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(kPio2Part1)));
+                r = _mm256_sub_pd(r, _mm256_mul_pd(n, _mm256_set1_pd(kPio2Part2)));
+                r = _mm256_sub_pd(r, _mm256_mul_pd(n, _mm256_set1_pd(kPio2Part3)));
+                const __m256d quarter = _mm256_sub_pd(_mm256_mul_pd(n, _mm256_set1_pd(0.25)), _mm256_set1_pd(0.375));
+                __m256d quadrant = _mm256_sub_pd(n, _mm256_mul_pd(_mm256_set1_pd(4.0),
+                    _mm256_sub_pd(_mm256_add_pd(quarter, magic), magic)));
+                if (is_cos) {
+                    quadrant = _mm256_add_pd(quadrant, one);
+                }
+
+                const __m256d z = _mm256_mul_pd(r, r);
+                __m256d sin_poly = _mm256_add_pd(_mm256_set1_pd(kS5), _mm256_mul_pd(z, _mm256_set1_pd(kS6)));
+                sin_poly = _mm256_add_pd(_mm256_set1_pd(kS4), _mm256_mul_pd(z, sin_poly));
+                sin_poly = _mm256_add_pd(_mm256_set1_pd(kS3), _mm256_mul_pd(z, sin_poly));
+                sin_poly = _mm256_add_pd(_mm256_set1_pd(kS2), _mm256_mul_pd(z, sin_poly));
+                sin_poly = _mm256_add_pd(_mm256_set1_pd(kS1), _mm256_mul_pd(z, sin_poly));
+                const __m256d sin_value = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(z, r), sin_poly));
+
+                __m256d cos_poly = _mm256_add_pd(_mm256_set1_pd(kC5), _mm256_mul_pd(z, _mm256_set1_pd(kC6)));
+                cos_poly = _mm256_add_pd(_mm256_set1_pd(kC4), _mm256_mul_pd(z, cos_poly));
+                cos_poly = _mm256_add_pd(_mm256_set1_pd(kC3), _mm256_mul_pd(z, cos_poly));
+                cos_poly = _mm256_add_pd(_mm256_set1_pd(kC2), _mm256_mul_pd(z, cos_poly));
+                cos_poly = _mm256_add_pd(_mm256_set1_pd(kC1), _mm256_mul_pd(z, cos_poly));
+                const __m256d half_z = _mm256_mul_pd(_mm256_set1_pd(0.5), z);
+                const __m256d w = _mm256_sub_pd(one, half_z);
+                const __m256d cos_value = _mm256_add_pd(w, _mm256_add_pd(
+                    _mm256_sub_pd(_mm256_sub_pd(one, w), half_z),
+                    _mm256_mul_pd(_mm256_mul_pd(z, z), cos_poly)));
+
+                const __m256d odd = _mm256_or_pd(_mm256_cmp_pd(quadrant, one, _CMP_EQ_OQ),
+                                                 _mm256_cmp_pd(quadrant, three, _CMP_EQ_OQ));
+                const __m256d negative = _mm256_or_pd(_mm256_cmp_pd(quadrant, two, _CMP_EQ_OQ),
+                                                      _mm256_cmp_pd(quadrant, three, _CMP_EQ_OQ));
+                __m256d result = _mm256_blendv_pd(sin_value, cos_value, odd);
+                result = _mm256_xor_pd(result, _mm256_and_pd(negative, sign_mask));
+                if (!is_cos) {
+                    const __m256d tiny = _mm256_cmp_pd(_mm256_and_pd(x, abs_mask),
+                                                       _mm256_set1_pd(kTinyArgument), _CMP_LT_OQ);
+                    result = _mm256_blendv_pd(result, x, tiny);
+                }
+                _mm256_storeu_pd(values + i, result);
+
+                // Большие и неконечные аргументы досчитываются через libm
+                const int fallback = _mm256_movemask_pd(out_of_range);
+                if (fallback != 0) {
+                    double arguments[4];
+                    _mm256_storeu_pd(arguments, x);
+                    for (int lane = 0; lane < 4; ++lane) {
+                        if (fallback & (1 << lane)) {
+                            values[i + lane] = is_cos ? std::cos(arguments[lane]) : std::sin(arguments[lane]);
+                        }
+                    }
+                }
+            }
+            for (; i < count; ++i) {
+                values[i] = SinCosScalar<is_cos>(values[i]);
+            }
+        }
+
+#endif
+
+        /* Набор ядер выбирается один раз по возможностям процессора */
+        struct Kernels {
+            bool (*add)(double*, const double*, size_t);
+            bool (*subtract)(double*, const double*, size_t);
+            bool (*multiply)(double*, const double*, size_t);
+            bool (*divide)(double*, const double*, size_t);
+            void (*negate)(double*, size_t);
+            bool (*all_finite)(const double*, size_t);
+            void (*sin)(double*, size_t);
+            void (*cos)(double*, size_t);
+            size_t (*gather)(double*, size_t, const double*, size_t);
+            const char* name;
+        };
+
+        /*
+            Переменная окружения CALCULATOR_SIMD ограничивает набор инструкций
+            значениями scalar, sse2, avx или avx2 (AVX2 отличается от AVX только
+            аппаратной выборкой факториалов): так ядра проверяются и сравниваются
+            на одной машине. Без переменной, как и со значением avx2, выбирается
+            лучший набор, доступный процессору.
+        */
+        Kernels SelectKernels() {
+            const char* limit = std::getenv("CALCULATOR_SIMD");
+            const std::string_view requested = limit != nullptr ? limit : "";
+            const Kernels scalar{BinaryPortable<BinaryKind::ADD>, BinaryPortable<BinaryKind::SUBTRACT>,
+                                 BinaryPortable<BinaryKind::MULTIPLY>, BinaryPortable<BinaryKind::DIVIDE>,
+                                 NegateScalar, AllFiniteScalar, SinCosPortable<false>, SinCosPortable<true>,
+                                 GatherPortable, "scalar"};
+            if (requested == "scalar") {
+                return scalar;
+            }
+#ifdef CALCULATOR_SIMD_AVX
+            if (requested != "sse2" && __builtin_cpu_supports("avx")) {
+                const bool avx2 = requested != "avx" && __builtin_cpu_supports("avx2");
+                return {BinaryAvx<BinaryKind::ADD>, BinaryAvx<BinaryKind::SUBTRACT>,
+                        BinaryAvx<BinaryKind::MULTIPLY>, BinaryAvx<BinaryKind::DIVIDE>,
+                        NegateAvx, AllFiniteAvx, SinCosAvx<false>, SinCosAvx<true>,
+                        avx2 ? GatherAvx2 : GatherAvx, avx2 ? "avx2" : "avx"};
+            }
+#endif
+#ifdef CALCULATOR_SIMD_X86
+            return {BinarySse2<BinaryKind::ADD>, BinarySse2<BinaryKind::SUBTRACT>,
+                    BinarySse2<BinaryKind::MULTIPLY>, BinarySse2<BinaryKind::DIVIDE>,
+                    NegateSse2, AllFiniteSse2, SinCosPortable<false>, SinCosPortable<true>, GatherSse2, "sse2"};
+#else
+            return scalar;
+#endif
+        }
+
+        const Kernels& GetKernels() {
+            static const Kernels kernels = SelectKernels();
+            return kernels;
+        }
+
+    } //End of anonymous namespace
+
+    bool Add(double* left, const double* right, size_t count) {
+        return GetKernels().add(left, right, count);
+    }
+
+    bool Subtract(double* left, const double* right, size_t count) {
+        return GetKernels().subtract(left, right, count);
+    }
+
+    bool Multiply(double* left, const double* right, size_t count) {
+        return GetKernels().multiply(left, right, count);
+    }
+
+    bool Divide(double* left, const double* right, size_t count) {
+        return GetKernels().divide(left, right, count);
+    }
+
+    void Negate(double* values, size_t count) {
+        GetKernels().negate(values, count);
+    }
+
+    bool AllFinite(const double* values, size_t count) {
+        return GetKernels().all_finite(values, count);
+    }
+
+    void Sin(double* values, size_t count) {
+        GetKernels().sin(values, count);
+    }
+
+    void Cos(double* values, size_t count) {
+        GetKernels().cos(values, count);
+    }
+
+    size_t Gather(double* values, size_t count, const double* table, size_t table_size) {
+        return GetKernels().gather(values, count, table, table_size);
+    }
+
+    const char* GetInstructionSet() {
+        return GetKernels().name;
+    }
+
+} //End of namespace Simd
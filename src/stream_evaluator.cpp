@@ -0,0 +1,74 @@
+#include "stream_evaluator.h"
+#include "variable_parser.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+    constexpr std::string_view kWhitespace = " \t\r";
+
+    std::string_view Trim(std::string_view text) {
+        const size_t begin = text.find_first_not_of(kWhitespace);
+        if (begin == std::string_view::npos) {
+            return {};
+        }
+        return text.substr(begin, text.find_last_not_of(kWhitespace) - begin + 1);
+    }
+
+} //End of anonymous namespace
+
+StreamEvaluator::StreamEvaluator(ExpressionCache& cache) : cache_(cache) {}
+
+void StreamEvaluator::Run(FileIo::LineReader& reader, OutputWriter& writer) {
+    for (std::string_view block = reader.NextBlock(); !block.empty(); block = reader.NextBlock()) {
+        FileIo::ForEachLine(block, [&](std::string_view line) {
+            try {
+                writer.WriteNumber(EvaluateLine(line));
+            } catch (const std::exception& e) {
+                if (writer.IsBinary()) {
+                    writer.WriteNumber(std::numeric_limits<double>::quiet_NaN());
+                }
+                writer.WriteText("Error: ");
+                writer.WriteText(e.what());
+            }
+            writer.WriteText("\n");
+        });
+        // Прочитанные данные закончились: ответы отдаются, не дожидаясь следующего блока
+        writer.Flush();
+    }
+}
+
+double StreamEvaluator::EvaluateLine(std::string_view line) {
+    const size_t separator = line.find(';');
+    const CompiledExpression& compiled = cache_.Get(Trim(line.substr(0, separator)));
+    const std::vector<std::string>& names = compiled.GetVariableNames();
+    slots_.assign(names.size(), 0.0);
+    bound_.assign(names.size(), false);
+    if (separator != std::string_view::npos) {
+        std::string_view bindings = line.substr(separator + 1);
+        while (true) {
+            const size_t begin = bindings.find_first_not_of(kWhitespace);
+            if (begin == std::string_view::npos) {
+                break;
+            }
+            bindings.remove_prefix(begin);
+            const size_t end = std::min(bindings.find_first_of(kWhitespace), bindings.size());
+            const VariableParser::Binding binding = VariableParser::ParseBinding(bindings.substr(0, end));
+            bindings.remove_prefix(end);
+            // Значения неиспользуемых переменных, как и в --var, не разрешаются
+            auto it = std::find(names.begin(), names.end(), binding.name);
+            if (it != names.end()) {
+                const size_t slot = static_cast<size_t>(it - names.begin());
+                slots_[slot] = VariableParser::ResolveValue(binding.value);
+                bound_[slot] = true;
+            }
+        }
+    }
+    for (size_t slot = 0; slot < names.size(); ++slot) {
+        if (!bound_[slot]) {
+            throw std::runtime_error("Unknown variable: " + names[slot]);
+        }
+    }
+    return compiled.Evaluate(slots_.data(), slots_.size());
+}
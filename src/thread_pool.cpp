@@ -0,0 +1,119 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    thread_count = std::max<size_t>(thread_count, 1);
+    for (size_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+/*
+    Задачи заранее раскладываются по очередям потоков равными непрерывными
+    диапазонами. Если задача выбросила исключение, после завершения всех
+    задач пробрасывается исключение задачи с наименьшим индексом, поэтому
+    результат не зависит от порядка выполнения.
+*/
+void ThreadPool::ParallelFor(size_t task_count, const std::function<void(size_t)>& task) {
+    if (task_count == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+
+    // Задача и счётчик публикуются до раскладки: поток, ещё не вышедший из
+    // предыдущего цикла, может сразу взять новую задачу
+    error_ = nullptr;
+    pending_ = task_count;
+    task_ = &task;
+
+    const size_t per_worker = (task_count + queues_.size() - 1) / queues_.size();
+    for (size_t i = 0; i < task_count; ++i) {
+        WorkQueue& queue = *queues_[i / per_worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(i);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void ThreadPool::WorkerLoop(size_t worker_index) {
+    size_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+            if (stop_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+        size_t task_index = 0;
+        while (PopTask(worker_index, task_index) || StealTask(worker_index, task_index)) {
+            RunTask(task_index);
+        }
+    }
+}
+
+bool ThreadPool::PopTask(size_t worker_index, size_t& task_index) {
+    WorkQueue& queue = *queues_[worker_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task_index = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool ThreadPool::StealTask(size_t worker_index, size_t& task_index) {
+    // Перехват идёт с конца чужой очереди, чтобы не мешать её владельцу
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        WorkQueue& queue = *queues_[(worker_index + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task_index = queue.tasks.back();
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::RunTask(size_t task_index) {
+    try {
+        (*task_.load())(task_index);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_ || task_index < error_index_) {
+            error_ = std::current_exception();
+            error_index_ = task_index;
+        }
+    }
+    if (--pending_ == 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_.notify_all();
+    }
+}
@@ -1,20 +1,92 @@
 #include "token.h"
+#include "simd_kernels.h"
+#include <array>
 #include <cmath>
-#include <variant>
-#include <sstream>
+#include <cstdint>
 
 namespace Token{
 
-    Constants GetDefaultConstants() {
-        return {
-            {"PI", M_PI}
+    namespace {
+
+        constexpr uint32_t HashIdentifier(std::string_view name, uint32_t seed) {
+            // FNV-1a с добавлением зерна
+            uint32_t hash = 2166136261u ^ seed;
+            for (char c : name) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+
+        /*
+            Таблица с совершенным хешированием: зерно подбирается при компиляции
+            так, чтобы все имена попали в разные ячейки. Ячейка хранит номер
+            записи плюс один (ноль - пустая ячейка), поэтому поиск сводится к
+            одному хешу и одному сравнению строк.
+        */
+        template <typename Entry, size_t N, size_t Slots>
+        class PerfectHashTable {
+            static_assert((Slots & (Slots - 1)) == 0 && Slots >= N, "Slots must be a power of two not less than N");
+        public:
+            constexpr explicit PerfectHashTable(const std::array<Entry, N>& entries)
+                : entries_(entries), slots_{}, seed_(0) {
+                for (uint32_t seed = 0; seed < kMaxSeed; ++seed) {
+                    if (TryBuild(seed)) {
+                        seed_ = seed;
+                        return;
+                    }
+                }
+                throw "No perfect hash seed found";
+            }
+
+            constexpr const Entry* Find(std::string_view name) const {
+                const uint8_t index = slots_[HashIdentifier(name, seed_) & (Slots - 1)];
+                if (index == 0 || entries_[index - 1].name != name) {
+                    return nullptr;
+                }
+                return &entries_[index - 1];
+            }
+
+        private:
+            static constexpr uint32_t kMaxSeed = 1u << 16;
+
+            constexpr bool TryBuild(uint32_t seed) {
+                for (auto& slot : slots_) {
+                    slot = 0;
+                }
+                for (size_t i = 0; i < N; ++i) {
+                    uint8_t& slot = slots_[HashIdentifier(entries_[i].name, seed) & (Slots - 1)];
+                    if (slot != 0) {
+                        return false;
+                    }
+                    slot = static_cast<uint8_t>(i + 1);
+                }
+                return true;
+            }
+
+        private:
+            std::array<Entry, N> entries_;
+            std::array<uint8_t, Slots> slots_;
+            uint32_t seed_;
         };
+
+        constexpr PerfectHashTable<ConstantEntry, 1, 2> kConstants(std::array<ConstantEntry, 1>{{
+            {"PI", M_PI}
+        }});
+
+        constexpr PerfectHashTable<FunctionEntry, 2, 4> kFunctions(std::array<FunctionEntry, 2>{{
+            {"sin", static_cast<double (*)(double)>(sin), Simd::Sin},
+            {"cos", static_cast<double (*)(double)>(cos), Simd::Cos}
+        }});
+
+    } //End of anonymous namespace
+
+    const ConstantEntry* FindConstant(std::string_view name) {
+        return kConstants.Find(name);
     }
 
-    Functions GetDefaultFunctions() {
-        return {
-            {"sin", sin}, {"cos", cos}
-        };
+    const FunctionEntry* FindFunction(std::string_view name) {
+        return kFunctions.Find(name);
     }
 
     bool IsOperator(TokenType type) {
@@ -24,4 +96,4 @@ namespace Token{
                type == TokenType::UNARY_MINUS;
     }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,57 @@
+#include "variable_parser.h"
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace VariableParser {
+
+    Value ParseValue(std::string_view text, std::string_view context) {
+        if (!text.empty() && isalpha(static_cast<unsigned char>(text.front()))) {
+            return text;
+        }
+        // Число должно занимать всё значение, как и в выражениях
+        double value{0.0};
+        const char* end = text.data() + text.size();
+        auto [ptr, ec] = std::from_chars(text.data(), end, value);
+        if (text.empty() || ec != std::errc() || ptr != end) {
+            throw std::runtime_error("Invalid number format in: "s + std::string(context));
+        }
+        return value;
+    }
+
+    Binding ParseBinding(std::string_view pair) {
+        const size_t eq_pos = pair.find('=');
+        if (eq_pos == std::string_view::npos || eq_pos == 0 || eq_pos == pair.size() - 1) {
+            throw std::runtime_error("Invalid variable format: "s + std::string(pair));
+        }
+        return Binding{pair.substr(0, eq_pos), ParseValue(pair.substr(eq_pos + 1), pair)};
+    }
+
+    double ResolveValue(const Value& value) {
+        if (const double* number = std::get_if<double>(&value)) {
+            return *number;
+        }
+        const std::string_view name = std::get<std::string_view>(value);
+        if (const Token::ConstantEntry* constant = Token::FindConstant(name)) {
+            return constant->value;
+        }
+        throw std::runtime_error("Unknown variable value: "s + std::string(name));
+    }
+
+    Token::Variables ParseVariables(const std::vector<std::string>& raw_vars) {
+        Token::Variables result_vars{};
+        for (const auto& arg : raw_vars) {
+            const Binding binding = ParseBinding(arg);
+            std::string name(binding.name);
+            if (const double* number = std::get_if<double>(&binding.value)) {
+                result_vars[name] = *number;
+            } else {
+                result_vars[name] = std::string(std::get<std::string_view>(binding.value));
+            }
+        }
+        return result_vars;
+    }
+
+} //End of namespace VariableParser
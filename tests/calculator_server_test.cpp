@@ -0,0 +1,159 @@
+#include "calculator_server.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+    Проверка сервера через настоящий сокет: длинная сумма вычисляется, а
+    ошибка в запросе, в том числе слишком глубокая вложенность, возвращается
+    кадром с кодом 1 и не мешает обработке следующих запросов того же и
+    других клиентов.
+*/
+
+namespace {
+
+    int failures = 0;
+
+    void Check(bool condition, const std::string& what) {
+        if (!condition) {
+            std::printf("FAIL %s\n", what.c_str());
+            ++failures;
+        }
+    }
+
+    int Connect(const std::string& path) {
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.data(), path.size());
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    bool SendAll(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            const ssize_t count = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (count <= 0) return false;
+            sent += static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    bool ReceiveAll(int fd, char* data, size_t size) {
+        size_t received = 0;
+        while (received < size) {
+            const ssize_t count = recv(fd, data + received, size - received, 0);
+            if (count <= 0) return false;
+            received += static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    std::string Frame(const std::string& request) {
+        std::string frame;
+        const uint32_t size = static_cast<uint32_t>(request.size());
+        for (int byte = 0; byte < 4; ++byte) frame.push_back(static_cast<char>(size >> (8 * byte) & 0xFF));
+        return frame + request;
+    }
+
+    struct Response {
+        bool received = false;
+        uint8_t status = 0;
+        double value = 0.0;
+        std::string error;
+    };
+
+    Response Receive(int fd) {
+        Response response;
+        unsigned char header[4];
+        if (!ReceiveAll(fd, reinterpret_cast<char*>(header), sizeof(header))) return response;
+        const uint32_t size = header[0] | header[1] << 8 | header[2] << 16 | static_cast<uint32_t>(header[3]) << 24;
+        std::string payload(size, '\0');
+        if (size == 0 || !ReceiveAll(fd, payload.data(), size)) return response;
+        response.received = true;
+        response.status = static_cast<uint8_t>(payload[0]);
+        if (response.status == CalculatorServer::kStatusOk && size == 9) {
+            std::memcpy(&response.value, payload.data() + 1, sizeof(double));
+        } else {
+            response.error = payload.substr(1);
+        }
+        return response;
+    }
+
+    Response Request(int fd, const std::string& request) {
+        if (!SendAll(fd, Frame(request))) return {};
+        return Receive(fd);
+    }
+
+} //End of anonymous namespace
+
+int main() {
+    const std::string path = "/tmp/calculator_server_test_" + std::to_string(getpid()) + ".sock";
+    Calculator calc;
+    ExpressionCache cache(calc);
+    auto server = std::make_unique<CalculatorServer>(cache, path);
+    std::thread loop([&] { server->Run(); });
+
+    const int client = Connect(path);
+    const int other = Connect(path);
+    Check(client >= 0 && other >= 0, "connect");
+
+    Response response = Request(client, "2 * x + y; x=3 y=1");
+    Check(response.received && response.status == CalculatorServer::kStatusOk && response.value == 7.0, "simple request");
+
+    // Сумма 100000 слагаемых (около 200 КБ) раньше переполняла стек сервера
+    std::string sum = "1";
+    for (int i = 1; i < 100000; ++i) sum += "+1";
+    response = Request(client, sum);
+    Check(response.received && response.status == CalculatorServer::kStatusOk && response.value == 100000.0,
+          "long sum is evaluated: " + response.error);
+    response = Request(client, std::string(100000, '(') + "1" + std::string(100000, ')'));
+    Check(response.received && response.status == CalculatorServer::kStatusError &&
+          response.error.find("Parse error") == 0, "deep nesting is rejected: " + response.error);
+
+    response = Request(client, "1/0");
+    Check(response.received && response.status == CalculatorServer::kStatusError, "evaluation error");
+    response = Request(client, "x!; x=5");
+    Check(response.received && response.status == CalculatorServer::kStatusOk && response.value == 120.0,
+          "connection survives errors");
+    response = Request(other, "PI - PI");
+    Check(response.received && response.status == CalculatorServer::kStatusOk && response.value == 0.0,
+          "other client is served");
+
+    // Кадр длиннее предела закрывает только своё соединение, и лишь после ответов на предыдущие запросы
+    const uint32_t oversized = CalculatorServer::kMaxRequestSize + 1;
+    const std::string header{static_cast<char>(oversized & 0xFF), static_cast<char>(oversized >> 8 & 0xFF),
+                             static_cast<char>(oversized >> 16 & 0xFF), static_cast<char>(oversized >> 24 & 0xFF)};
+    Check(SendAll(client, Frame("6 * 7") + Frame("x; x=1") + header), "pipelined requests before an oversized frame");
+    response = Receive(client);
+    Check(response.received && response.value == 42.0, "response before an oversized frame is delivered");
+    response = Receive(client);
+    Check(response.received && response.value == 1.0, "all responses before an oversized frame are delivered");
+    Check(!Receive(client).received, "oversized frame closes the connection");
+    response = Request(other, "1 + 1");
+    Check(response.received && response.value == 2.0, "other client survives an oversized frame");
+
+    close(client);
+    close(other);
+    server->Stop();
+    loop.join();
+    server.reset();
+    Check(access(path.c_str(), F_OK) != 0, "socket file is removed");
+
+    if (failures != 0) {
+        std::printf("%d failures\n", failures);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include "calculator.h"
+#include "expression_cache.h"
+#include "parser.h"
+#include "stream_evaluator.h"
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+/*
+    Проверка глубоких выражений: длинные цепочки вида 1 + 1 + ... + 1
+    вычисляются всеми движками без переполнения стека, а вложенность
+    глубже Parser::kMaxDepth (скобки, функции, факториалы) даёт ошибку
+    разбора (std::runtime_error). В режиме --stream такая строка получает
+    сообщение об ошибке, не прерывая остальные.
+*/
+
+namespace {
+
+    int failures = 0;
+
+    // term op term op ... - левоассоциативная цепочка из count операндов
+    std::string Chain(const std::string& term, const char* op, size_t count) {
+        std::string expression = term;
+        for (size_t i = 1; i < count; ++i) {
+            expression += op;
+            expression += term;
+        }
+        return expression;
+    }
+
+    std::string Brackets(size_t depth) {
+        return std::string(depth, '(') + "x" + std::string(depth, ')');
+    }
+
+    std::string Functions(size_t depth) {
+        std::string expression;
+        for (size_t i = 0; i < depth; ++i) expression += "sin(";
+        return expression + "x" + std::string(depth, ')');
+    }
+
+    std::string Factorials(size_t count) {
+        return "0" + std::string(count, '!');
+    }
+
+    const char* EngineName(Engine engine) {
+        switch (engine) {
+            case Engine::TREE_WALKER: return "tree";
+            case Engine::BYTECODE: return "bytecode";
+            case Engine::JIT: return "jit";
+        }
+        return "?";
+    }
+
+    CompileOptions Options(Engine engine, bool optimize) {
+        CompileOptions options;
+        options.engine = engine;
+        options.fold_constants = optimize;
+        options.eliminate_common_subexpressions = optimize;
+        return options;
+    }
+
+    void ExpectRejected(const Calculator& calc, const char* name, const std::string& expression,
+                        const CompileOptions& options) {
+        const Engine engine = options.engine;
+        try {
+            calc.Compile(expression, options);
+            std::printf("FAIL %s (%zu bytes, %s): accepted\n", name, expression.size(), EngineName(engine));
+            ++failures;
+        } catch (const std::runtime_error& e) {
+            if (std::string(e.what()).find("Parse error") != 0) {
+                std::printf("FAIL %s (%s): unexpected error: %s\n", name, EngineName(engine), e.what());
+                ++failures;
+            }
+        }
+    }
+
+    void ExpectValue(const Calculator& calc, const char* name, const std::string& expression,
+                     const CompileOptions& options, double expected, const Token::Variables& vars = {{"x", 0.5}}) {
+        const Engine engine = options.engine;
+        try {
+            const double result = calc.Compile(expression, options).Evaluate(vars);
+            if (result != expected) {
+                std::printf("FAIL %s (%s): expected %.17g, got %.17g\n", name, EngineName(engine), expected, result);
+                ++failures;
+            }
+        } catch (const std::exception& e) {
+            std::printf("FAIL %s (%s): %s\n", name, EngineName(engine), e.what());
+            ++failures;
+        }
+    }
+
+    // Прогоняет ввод через StreamEvaluator::Run, как это делает --stream
+    std::string RunStream(const std::string& input) {
+        std::FILE* in = std::tmpfile();
+        std::FILE* out = std::tmpfile();
+        std::fwrite(input.data(), 1, input.size(), in);
+        std::fflush(in);
+        std::rewind(in);
+        Calculator calc;
+        ExpressionCache cache(calc);
+        StreamEvaluator evaluator(cache);
+        FileIo::LineReader reader = FileIo::LineReader::Open(fileno(in));
+        OutputWriter writer(fileno(out));
+        evaluator.Run(reader, writer);
+        std::string output;
+        std::rewind(out);
+        char buffer[4096];
+        for (size_t read; (read = std::fread(buffer, 1, sizeof(buffer), out)) != 0;) {
+            output.append(buffer, read);
+        }
+        std::fclose(in);
+        std::fclose(out);
+        return output;
+    }
+
+    void CheckStream() {
+        const std::string input = Chain("1", "+", 100000) + "\n2 + 2\n" + Brackets(100000) + "; x=1\nx * 2; x=3\n";
+        const std::string expected =
+            "1e+05\n"
+            "4\n"
+            "Error: Parse error: Brackets are nested deeper than 1000 levels\n"
+            "6\n";
+        try {
+            const std::string output = RunStream(input);
+            if (output != expected) {
+                std::printf("FAIL stream: unexpected output:\n%s", output.c_str());
+                ++failures;
+            }
+        } catch (const std::exception& e) {
+            std::printf("FAIL stream: %s\n", e.what());
+            ++failures;
+        }
+    }
+
+} //End of anonymous namespace
+
+int main() {
+    const size_t limit = Parser::kMaxDepth;
+    const double nested_sine = [limit] {
+        double value = 0.5;
+        for (size_t i = 0; i < limit; ++i) value = std::sin(value);
+        return value;
+    }();
+    Token::Variables numbered;
+    std::string numbered_sum = "x1";
+    for (size_t i = 1; i <= 2000; ++i) {
+        numbered["x" + std::to_string(i)] = static_cast<double>(i);
+        if (i > 1) numbered_sum += "+x" + std::to_string(i);
+    }
+
+    Calculator calc;
+    for (Engine engine : {Engine::TREE_WALKER, Engine::BYTECODE, Engine::JIT}) {
+        for (bool optimize : {false, true}) {
+            const CompileOptions options = Options(engine, optimize);
+            // Длина цепочки не ограничена
+            ExpectValue(calc, "sum of 100000 numbers", Chain("1", "+", 100000), options, 100000.0);
+            ExpectValue(calc, "sum of 100000 variables", Chain("x", "+", 100000), options, 50000.0);
+            ExpectValue(calc, "product of 100000 variables", Chain("x", "*", 100000), options, 0.0);
+            ExpectValue(calc, "sum of 2000 distinct variables", numbered_sum, options, 2001000.0, numbered);
+            ExpectValue(calc, "chains with a common prefix",
+                        "(" + Chain("x", "+", 1000) + ") * (" + Chain("x", "+", 500) + ")", options, 125000.0);
+            // Вложенность предельной глубины
+            ExpectValue(calc, "brackets at limit", Brackets(limit), options, 0.5);
+            ExpectValue(calc, "functions at limit", Functions(limit), options, nested_sine);
+            ExpectValue(calc, "factorials at limit", Factorials(limit), options, 1.0);
+
+            ExpectRejected(calc, "brackets over limit", Brackets(limit + 1), options);
+            ExpectRejected(calc, "100000 brackets", Brackets(100000), options);
+            ExpectRejected(calc, "functions over limit", Functions(limit + 1), options);
+            ExpectRejected(calc, "factorials over limit", Factorials(limit + 1), options);
+            ExpectRejected(calc, "100000 factorials", Factorials(100000), options);
+        }
+    }
+    CheckStream();
+    if (failures != 0) {
+        std::printf("%d failures\n", failures);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "calculator.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+/*
+    Проверка порядка ошибок: при нескольких ошибках в выражении сообщается
+    та, до которой вычисление слева направо доходит первой, как при обходе
+    дерева. Неизвестная переменная не должна заслонять ошибку в части
+    выражения перед ней, и наоборот. Порядок одинаков для всех движков,
+    для отложенной проверки по флагам FPU и для Calculator::Calculate.
+    Compile со свёрткой констант сообщает ошибки константных подвыражений
+    уже при компиляции.
+*/
+
+namespace {
+
+    int failures = 0;
+
+    const char* EngineName(Engine engine) {
+        switch (engine) {
+            case Engine::TREE_WALKER: return "tree";
+            case Engine::BYTECODE: return "bytecode";
+            case Engine::JIT: return "jit";
+        }
+        return "?";
+    }
+
+    void ExpectError(const Calculator& calc, const std::string& expression, const Token::Variables& vars,
+                     const CompileOptions& options, const std::string& expected) {
+        try {
+            const double result = calc.Compile(expression, options).Evaluate(vars);
+            std::printf("FAIL %s (%s): expected \"%s\", got %.17g\n", expression.c_str(), EngineName(options.engine),
+                        expected.c_str(), result);
+            ++failures;
+        } catch (const std::runtime_error& e) {
+            if (e.what() != expected) {
+                std::printf("FAIL %s (%s): expected \"%s\", got \"%s\"\n", expression.c_str(),
+                            EngineName(options.engine), expected.c_str(), e.what());
+                ++failures;
+            }
+        }
+    }
+
+    void ExpectCalculateError(Calculator& calc, const std::string& expression, const Token::Variables& vars,
+                              const std::string& expected) {
+        try {
+            const double result = calc.Calculate(expression, vars);
+            std::printf("FAIL Calculate(%s): expected \"%s\", got %.17g\n", expression.c_str(), expected.c_str(),
+                        result);
+            ++failures;
+        } catch (const std::runtime_error& e) {
+            if (e.what() != expected) {
+                std::printf("FAIL Calculate(%s): expected \"%s\", got \"%s\"\n", expression.c_str(),
+                            expected.c_str(), e.what());
+                ++failures;
+            }
+        }
+    }
+
+    void ExpectCompileError(const Calculator& calc, const std::string& expression, const std::string& expected) {
+        try {
+            calc.Compile(expression);
+            std::printf("FAIL Compile(%s): expected \"%s\"\n", expression.c_str(), expected.c_str());
+            ++failures;
+        } catch (const std::runtime_error& e) {
+            if (e.what() != expected) {
+                std::printf("FAIL Compile(%s): expected \"%s\", got \"%s\"\n", expression.c_str(),
+                            expected.c_str(), e.what());
+                ++failures;
+            }
+        }
+    }
+
+} //End of anonymous namespace
+
+int main() {
+    const std::string non_finite = "Infinite result or Nan";
+    const Token::Variables x{{"x", 1.0}};
+
+    Calculator calc;
+    for (Engine engine : {Engine::TREE_WALKER, Engine::BYTECODE, Engine::JIT}) {
+        for (bool deferred : {false, true}) {
+            CompileOptions options;
+            options.engine = engine;
+            options.deferred_fp_checks = deferred;
+
+            ExpectError(calc, "x/0 + y", x, options, non_finite);
+            ExpectError(calc, "y + x/0", x, options, "Unknown variable: y");
+            ExpectError(calc, "x * 1e308 * 10 - y", x, options, non_finite);
+            ExpectError(calc, "(x - 2)! + y", x, options, "Factorial is only defined for non-negative integers");
+            ExpectError(calc, "sin(x) * (y + z)", x, options, "Unknown variable: y");
+            ExpectError(calc, "z + y", x, options, "Unknown variable: z");
+        }
+    }
+    // Однократное вычисление следует порядку обхода дерева
+    ExpectCalculateError(calc, "x + 1/0", {}, "Unknown variable: x");
+    ExpectCalculateError(calc, "x + 1/0", x, non_finite);
+    ExpectCalculateError(calc, "1/0 + x", {}, non_finite);
+    ExpectCalculateError(calc, "y * (-1)! + 2", {}, "Unknown variable: y");
+    // Со свёрткой ошибка константного подвыражения сообщается при компиляции
+    ExpectCompileError(calc, "x + 1/0", non_finite);
+    ExpectCompileError(calc, "y * (-1)!", "Factorial is only defined for non-negative integers");
+    if (failures != 0) {
+        std::printf("%d failures\n", failures);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
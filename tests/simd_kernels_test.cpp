@@ -0,0 +1,151 @@
+#include "simd_kernels.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <vector>
+
+/*
+    Проверка векторных ядер арифметики: результаты должны побитово совпадать
+    со скалярными операторами для всех длин блока, включая хвосты, не кратные
+    ширине SSE2 и AVX, и для особых значений (inf, NaN, денормализованные
+    числа, нули разного знака). Набор инструкций выбирается переменной
+    окружения CALCULATOR_SIMD; ctest запускает проверку для каждого набора.
+*/
+
+namespace {
+
+    constexpr size_t kMaxLength = 70;
+    constexpr size_t kBlockLengths[] = {255, 256, 257};
+    constexpr int kRounds = 50;
+
+    int failures = 0;
+
+    uint64_t Bits(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    /*
+        Знак и полезная нагрузка NaN, полученного из двух NaN-операндов, не
+        определены IEEE 754 и зависят от порядка операндов, который компилятор
+        может переставить в коммутативной операции даже в скалярном коде,
+        поэтому NaN сравниваются только как NaN. Остальные значения, включая
+        знак нуля и денормализованные числа, сравниваются побитово.
+    */
+    bool Identical(double expected, double actual) {
+        if (std::isnan(expected)) return std::isnan(actual);
+        return Bits(expected) == Bits(actual);
+    }
+
+    void Fail(const char* kernel, size_t length, size_t index, double expected, double actual) {
+        if (++failures <= 20) {
+            std::printf("FAIL %s length=%zu index=%zu: expected %a (0x%016llx), got %a (0x%016llx)\n", kernel, length,
+                        index, expected, static_cast<unsigned long long>(Bits(expected)), actual,
+                        static_cast<unsigned long long>(Bits(actual)));
+        }
+    }
+
+    void FailFlag(const char* kernel, size_t length, bool expected) {
+        if (++failures <= 20) {
+            std::printf("FAIL %s length=%zu: expected finite flag %d\n", kernel, length, expected);
+        }
+    }
+
+    // Смесь обычных и особых значений; особые попадают и в векторную часть, и в хвост
+    std::vector<double> MakeValues(std::mt19937_64& generator, size_t length) {
+        const double special[] = {
+            0.0, -0.0, 1.0, -1.0,
+            std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+            std::numeric_limits<double>::quiet_NaN(), -std::numeric_limits<double>::quiet_NaN(),
+            std::numeric_limits<double>::denorm_min(), -std::numeric_limits<double>::denorm_min(),
+            std::numeric_limits<double>::min() / 3.0, std::numeric_limits<double>::min(),
+            std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(), 1e-300, 1e300,
+        };
+        std::uniform_real_distribution<double> real(-1e3, 1e3);
+        std::uniform_int_distribution<size_t> pick(0, 3 * std::size(special));
+        std::vector<double> values(length);
+        for (double& value : values) {
+            const size_t index = pick(generator);
+            value = index < std::size(special) ? special[index] : real(generator);
+        }
+        return values;
+    }
+
+    bool ExpectedFinite(const std::vector<double>& values) {
+        for (double value : values) {
+            if (!std::isfinite(value)) return false;
+        }
+        return true;
+    }
+
+    template <typename Kernel, typename Scalar>
+    void CheckBinary(const char* name, Kernel kernel, Scalar scalar, const std::vector<double>& left,
+                     const std::vector<double>& right) {
+        std::vector<double> expected(left.size());
+        for (size_t i = 0; i < left.size(); ++i) {
+            expected[i] = scalar(left[i], right[i]);
+        }
+        std::vector<double> actual = left;
+        const bool finite = kernel(actual.data(), right.data(), actual.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+            if (!Identical(expected[i], actual[i])) Fail(name, actual.size(), i, expected[i], actual[i]);
+        }
+        if (finite != ExpectedFinite(expected)) FailFlag(name, actual.size(), ExpectedFinite(expected));
+    }
+
+    void CheckLength(std::mt19937_64& generator, size_t length) {
+        const std::vector<double> left = MakeValues(generator, length);
+        const std::vector<double> right = MakeValues(generator, length);
+
+        CheckBinary("Add", Simd::Add, [](double a, double b) { return a + b; }, left, right);
+        CheckBinary("Subtract", Simd::Subtract, [](double a, double b) { return a - b; }, left, right);
+        CheckBinary("Multiply", Simd::Multiply, [](double a, double b) { return a * b; }, left, right);
+        CheckBinary("Divide", Simd::Divide, [](double a, double b) { return a / b; }, left, right);
+
+        std::vector<double> negated = left;
+        Simd::Negate(negated.data(), negated.size());
+        for (size_t i = 0; i < length; ++i) {
+            if (Bits(negated[i]) != Bits(-left[i])) Fail("Negate", length, i, -left[i], negated[i]);
+        }
+
+        if (Simd::AllFinite(left.data(), length) != ExpectedFinite(left)) {
+            FailFlag("AllFinite", length, ExpectedFinite(left));
+        }
+        // Конечный блок с единственным особым значением в каждой позиции
+        std::vector<double> finite(length, 1.5);
+        for (size_t i = 0; i < length; ++i) {
+            for (double value : {std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN()}) {
+                finite[i] = value;
+                if (Simd::AllFinite(finite.data(), length)) FailFlag("AllFinite", length, false);
+            }
+            finite[i] = std::numeric_limits<double>::denorm_min();
+            if (!Simd::AllFinite(finite.data(), length)) FailFlag("AllFinite", length, true);
+            finite[i] = 1.5;
+        }
+    }
+
+} //End of anonymous namespace
+
+int main() {
+    std::printf("instruction set: %s\n", Simd::GetInstructionSet());
+    std::mt19937_64 generator(5);
+    for (int round = 0; round < kRounds; ++round) {
+        for (size_t length = 0; length <= kMaxLength; ++length) {
+            CheckLength(generator, length);
+        }
+        for (size_t length : kBlockLengths) {
+            CheckLength(generator, length);
+        }
+    }
+    if (failures != 0) {
+        std::printf("%d failures\n", failures);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}